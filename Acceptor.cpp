@@ -1,10 +1,15 @@
 #include "Acceptor.h"
+#include "EventLoop.h"
 #include "Logger.h"
 #include "InetAddress.h"
+#include "Timestamp.h"
 
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <strings.h>
 
 static int createNonblocking()
 {
@@ -21,10 +26,14 @@ Acceptor::Acceptor(EventLoop* loop, const InetAddress& addr, bool reuseport)
     , acceptSocket_(createNonblocking())
     , acceptChannel_(loop, acceptSocket_.fd())
     , listenning_(false)
+    , acceptBatch_(kDefaultAcceptBatch)
+    , multishotAccept_(true)
+    , idleFd_(::open("/dev/null", O_RDONLY | O_CLOEXEC))
 {
     acceptSocket_.setReuseAddr(true);
     acceptSocket_.setReusePort(reuseport);
     acceptSocket_.bindAddress(addr);
+    acceptChannel_.setName("Acceptor " + addr.toIpPort());
     // 当acceptor响应一个用户连接时，要执行一个回调
     acceptChannel_.setReadEventCallback(std::bind(&Acceptor::handleRead, this));
 }
@@ -33,39 +42,141 @@ Acceptor::~Acceptor()
 {
     acceptChannel_.disableAll();
     acceptChannel_.remove();
+    if (idleFd_ >= 0)
+    {
+        ::close(idleFd_);
+    }
 }
 
 void Acceptor::listen()
 {
     listenning_ = true;
     acceptSocket_.listen();
+    if (multishotAccept_)
+    {
+        // 只有io_uring支持，其他后端继续等可读事件再accept
+        multishotAccept_ = loop_->enableMultishotAccept(&acceptChannel_);
+    }
     acceptChannel_.enableReading(); // 把Channel注册到Poller中
 }
 
-// listenfd有事件发生，即有新用户连接
+// listenfd有事件发生，即有新用户连接，一次最多accept acceptBatch_个
 void Acceptor::handleRead()
 {
-    InetAddress peerAddr;
-    int connfd = acceptSocket_.accept(&peerAddr);
-    if (connfd >= 0)
+    if (multishotAccept_)
     {
-        if (newConnectionCallback_)
+        if (loop_->takeAccepted(&acceptChannel_, &accepted_))
+        {
+            handleAccepted();
+            return;
+        }
+        multishotAccept_ = false; // poller退回了可读事件
+    }
+
+    int dropped = 0;
+    for (int i = 0; i < acceptBatch_; ++i)
+    {
+        InetAddress peerAddr;
+        int connfd = acceptSocket_.accept(&peerAddr);
+        if (connfd >= 0)
+        {
+            newConnection(connfd, peerAddr);
+            continue;
+        }
+
+        int savedErrno = errno;
+        if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK)
+        {
+            break; // accept队列已经取完
+        }
+        else if (savedErrno == EMFILE || savedErrno == ENFILE)
         {
-            newConnectionCallback_(connfd, peerAddr); // 轮询找到subloop，唤醒、分发当前的新客户端的Channel
+            if (dropPendingConnection())
+            {
+                ++dropped;
+            }
+            if (idleFd_ < 0)
+            {
+                break; // 没有预留的fd了，只能等下一次可读事件
+            }
+        }
+        else if (savedErrno == ECONNABORTED || savedErrno == EINTR || savedErrno == EPROTO || savedErrno == EPERM)
+        {
+            continue; // 对端在accept之前就断开了之类的暂时错误，继续取下一个
         }
         else
         {
-            ::close(connfd);
+            LOG_ERROR("%s:%s:%d accept error: %d\n", __FILE__, __FUNCTION__, __LINE__, savedErrno);
+            break;
         }
     }
-    else
+
+    if (dropped > 0)
+    {
+        LOG_ERROR("%s:%s:%d sockfd reached limit, %d connection(s) dropped \n", __FILE__, __FUNCTION__, __LINE__, dropped);
+    }
+}
+
+// 完成式accept：连接已经由内核accept好，只需要取对端地址
+void Acceptor::handleAccepted()
+{
+    int dropped = 0;
+    for (int connfd : accepted_)
     {
-        LOG_ERROR("%s:%s:%d accept error: %d\n", __FILE__, __FUNCTION__, __LINE__, errno);
-        if (errno == EMFILE)
+        if (connfd >= 0)
+        {
+            sockaddr_in addr;
+            socklen_t len = sizeof addr;
+            bzero(&addr, sizeof addr);
+            ::getpeername(connfd, (sockaddr*)&addr, &len);
+            newConnection(connfd, InetAddress(addr));
+        }
+        else if (connfd == -EMFILE || connfd == -ENFILE)
         {
-            LOG_ERROR("%s:%s:%d sockfd reached limit \n", __FILE__, __FUNCTION__, __LINE__);
+            if (dropPendingConnection())
+            {
+                ++dropped;
+            }
         }
+        else if (connfd != -ECONNABORTED && connfd != -EINTR && connfd != -EPROTO && connfd != -EPERM)
+        {
+            LOG_ERROR("%s:%s:%d accept error: %d\n", __FILE__, __FUNCTION__, __LINE__, -connfd);
+        }
+    }
+    accepted_.clear();
 
+    if (dropped > 0)
+    {
+        LOG_ERROR("%s:%s:%d sockfd reached limit, %d connection(s) dropped \n", __FILE__, __FUNCTION__, __LINE__, dropped);
+    }
+}
+
+void Acceptor::newConnection(int connfd, const InetAddress& peerAddr)
+{
+    if (newConnectionCallback_)
+    {
+        newConnectionCallback_(connfd, peerAddr); // 轮询找到subloop，唤醒、分发当前的新客户端的Channel
+    }
+    else
+    {
+        ::close(connfd);
     }
+}
 
-}
\ No newline at end of file
+// 关掉预留的fd腾出一个位置，把一个等待中的连接accept出来直接关闭，然后重新预留
+bool Acceptor::dropPendingConnection()
+{
+    bool dropped = false;
+    if (idleFd_ >= 0)
+    {
+        ::close(idleFd_);
+        idleFd_ = ::accept(acceptSocket_.fd(), nullptr, nullptr);
+        if (idleFd_ >= 0)
+        {
+            ::close(idleFd_);
+            dropped = true;
+        }
+        idleFd_ = ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+    return dropped;
+}
@@ -5,6 +5,7 @@
 #include "Channel.h"
 
 #include <functional>
+#include <vector>
 
 class InetAddress;
 class EventLoop;
@@ -14,6 +15,9 @@ class Acceptor : noncopyable
 public:
     using NewConnectionCallback = std::function<void(int sockfd, const InetAddress&)>;
 
+    // 每次可读事件默认最多accept的连接数
+    static const int kDefaultAcceptBatch = 16;
+
     Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reuseport);
     ~Acceptor();
 
@@ -22,11 +26,22 @@ public:
         newConnectionCallback_ = cb;
     }
 
+    // 每次可读事件最多accept多少个连接，连接风暴时减少epoll_wait的次数
+    void setAcceptBatch(int n) { acceptBatch_ = n > 0 ? n : 1; }
+    // loop使用io_uring时由内核multishot accept，默认开启，在listen之前设置
+    void setMultishotAccept(bool on) { multishotAccept_ = on; }
+    bool multishotAccept() const { return multishotAccept_; }
+
     bool listenning() const { return listenning_; }
     void listen();
 
 private:
     void handleRead();
+    // 处理poller中已经accept好的连接
+    void handleAccepted();
+    void newConnection(int connfd, const InetAddress& peerAddr);
+    // fd耗尽时accept一个等待中的连接并立即关闭，返回是否关掉了一个
+    bool dropPendingConnection();
 
     EventLoop* loop_; // Acceptor用的就是用户定义的baseloop
     Socket acceptSocket_;
@@ -34,6 +49,12 @@ private:
 
     NewConnectionCallback newConnectionCallback_;
     bool listenning_;
+    int acceptBatch_;
+    bool multishotAccept_;
+    std::vector<int> accepted_; // 从poller中取出的fd，负数是accept的错误码
+    // 预留的空闲fd，fd耗尽（EMFILE）时腾出来accept并立即关闭等待中的连接，
+    // 否则连接一直留在accept队列里，水平触发的listenfd会让loop空转
+    int idleFd_;
 
 
 };
\ No newline at end of file
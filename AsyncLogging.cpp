@@ -0,0 +1,159 @@
+#include "AsyncLogging.h"
+#include "LogFile.h"
+#include "Timestamp.h"
+
+#include <chrono>
+#include <stdio.h>
+
+AsyncLogging::AsyncLogging(const std::string& basename,
+                           off_t rollSize,
+                           int flushInterval,
+                           size_t maxQueuedBuffers)
+    : flushInterval_(flushInterval)
+    , maxQueuedBuffers_(maxQueuedBuffers)
+    , running_(false)
+    , basename_(basename)
+    , rollSize_(rollSize)
+    , thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging")
+    , currentBuffer_(new LogBuffer)
+    , nextBuffer_(new LogBuffer)
+    , dropped_(0)
+{
+    buffers_.reserve(maxQueuedBuffers_);
+}
+
+AsyncLogging::~AsyncLogging()
+{
+    if (running_)
+    {
+        stop();
+    }
+}
+
+void AsyncLogging::start()
+{
+    running_ = true;
+    thread_.start();
+}
+
+void AsyncLogging::stop()
+{
+    running_ = false;
+    cond_.notify_one();
+    thread_.join();
+}
+
+void AsyncLogging::append(const char* logline, size_t len)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!currentBuffer_) // 已经stop
+    {
+        ++dropped_;
+        return;
+    }
+    if (currentBuffer_->avail() > len)
+    {
+        currentBuffer_->append(logline, len);
+        return;
+    }
+
+    // 后台线程跟不上，丢弃这条日志，而不是阻塞或者无限申请内存
+    if (buffers_.size() >= maxQueuedBuffers_)
+    {
+        ++dropped_;
+        return;
+    }
+
+    buffers_.push_back(std::move(currentBuffer_));
+    if (nextBuffer_)
+    {
+        currentBuffer_ = std::move(nextBuffer_);
+    }
+    else
+    {
+        currentBuffer_.reset(new LogBuffer); // 很少发生
+    }
+    currentBuffer_->append(logline, len);
+    cond_.notify_one();
+}
+
+void AsyncLogging::threadFunc()
+{
+    LogFile output(basename_, rollSize_);
+    BufferPtr newBuffer1(new LogBuffer);
+    BufferPtr newBuffer2(new LogBuffer);
+    BufferVector buffersToWrite;
+    buffersToWrite.reserve(maxQueuedBuffers_ + 1);
+    int64_t reportedDropped = 0;
+
+    while (running_)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (buffers_.empty())
+            {
+                cond_.wait_for(lock, std::chrono::seconds(flushInterval_));
+            }
+            // 当前缓冲区也一起交换出来，前端换上空的缓冲区继续写
+            buffers_.push_back(std::move(currentBuffer_));
+            currentBuffer_ = std::move(newBuffer1);
+            buffersToWrite.swap(buffers_);
+            if (!nextBuffer_)
+            {
+                nextBuffer_ = std::move(newBuffer2);
+            }
+        }
+
+        int64_t dropped = dropped_;
+        if (dropped != reportedDropped)
+        {
+            char buf[128];
+            int n = snprintf(buf, sizeof buf, "%s : AsyncLogging dropped %ld log messages\n",
+                             Timestamp::now().toString().c_str(),
+                             static_cast<long>(dropped - reportedDropped));
+            output.append(buf, n);
+            reportedDropped = dropped;
+        }
+
+        // 在锁外批量写文件
+        for (const BufferPtr& buffer : buffersToWrite)
+        {
+            output.append(buffer->data(), buffer->length());
+        }
+
+        // 只保留两块缓冲区用来填充newBuffer1和newBuffer2，其余的释放掉
+        if (buffersToWrite.size() > 2)
+        {
+            buffersToWrite.resize(2);
+        }
+        if (!newBuffer1)
+        {
+            newBuffer1 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer1->reset();
+        }
+        if (!newBuffer2)
+        {
+            newBuffer2 = std::move(buffersToWrite.back());
+            buffersToWrite.pop_back();
+            newBuffer2->reset();
+        }
+        buffersToWrite.clear();
+        output.flush();
+    }
+
+    // 退出前把前端剩余的日志写完
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        buffers_.push_back(std::move(currentBuffer_));
+        buffersToWrite.swap(buffers_);
+    }
+    for (const BufferPtr& buffer : buffersToWrite)
+    {
+        if (buffer)
+        {
+            output.append(buffer->data(), buffer->length());
+        }
+    }
+    output.flush();
+}
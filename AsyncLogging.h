@@ -0,0 +1,88 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <sys/types.h>
+
+// 固定大小的日志缓冲区，写满之后整块交给后台线程
+class LogBuffer : noncopyable
+{
+public:
+    static const size_t kSize = 4 * 1024 * 1024;
+
+    LogBuffer() : cur_(data_) {}
+
+    void append(const char* buf, size_t len)
+    {
+        memcpy(cur_, buf, len);
+        cur_ += len;
+    }
+
+    const char* data() const { return data_; }
+    size_t length() const { return static_cast<size_t>(cur_ - data_); }
+    size_t avail() const { return static_cast<size_t>(end() - cur_); }
+    void reset() { cur_ = data_; }
+
+private:
+    const char* end() const { return data_ + sizeof data_; }
+
+    char data_[kSize];
+    char* cur_;
+};
+
+/**
+ * 异步日志，双缓冲：前端线程把日志追加到currentBuffer_，写满后放入buffers_
+ * 后台线程定期（或者有缓冲区写满时）把所有写满的缓冲区交换出来，批量写入滚动文件
+ * 待写的缓冲区个数达到maxQueuedBuffers时，前端直接丢弃日志并计数，不会阻塞IO线程
+ *
+ * 使用方法：
+ *   AsyncLogging log("server", 500*1000*1000);
+ *   log.start();
+ *   Logger::setOutput(...); // 转调log.append
+*/
+class AsyncLogging : noncopyable
+{
+public:
+    AsyncLogging(const std::string& basename,
+                 off_t rollSize,
+                 int flushInterval = 3,
+                 size_t maxQueuedBuffers = 16);
+    ~AsyncLogging();
+
+    // 前端调用，线程安全
+    void append(const char* logline, size_t len);
+
+    void start();
+    void stop();
+
+    // 因为后台来不及写而被丢弃的日志条数
+    int64_t droppedMessages() const { return dropped_; }
+
+private:
+    void threadFunc();
+
+    using BufferPtr = std::unique_ptr<LogBuffer>;
+    using BufferVector = std::vector<BufferPtr>;
+
+    const int flushInterval_; // 秒，后台至少每隔这么久刷一次盘
+    const size_t maxQueuedBuffers_;
+    std::atomic_bool running_;
+    const std::string basename_;
+    const off_t rollSize_;
+    Thread thread_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    BufferPtr currentBuffer_; // 当前正在写的缓冲区
+    BufferPtr nextBuffer_; // 预备的缓冲区
+    BufferVector buffers_; // 已写满，等待后台写入文件的缓冲区
+    std::atomic<int64_t> dropped_;
+};
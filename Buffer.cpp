@@ -1,23 +1,210 @@
 #include "Buffer.h"
+#include "BufferPool.h"
 
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
+const size_t Buffer::kCheapPrepend;
+const size_t Buffer::kInitialSize;
+const size_t Buffer::kMaxReadHint;
+
+static_assert(BufferPool::kBlockHeadroom == Buffer::kCheapPrepend,
+              "pooled blocks must leave room for the prepend area");
+
+static char* allocateBlock(BufferPool* pool, size_t size, size_t* actual)
+{
+    if (pool)
+    {
+        return pool->allocate(size, actual);
+    }
+    *actual = size;
+    return static_cast<char*>(::malloc(size));
+}
+
+static void freeBlock(BufferPool* pool, char* block, size_t actual)
+{
+    if (pool)
+    {
+        pool->deallocate(block, actual);
+    }
+    else
+    {
+        ::free(block);
+    }
+}
+
+Buffer::Buffer(size_t initialSize)
+    : buffer_(nullptr)
+    , capacity_(0)
+    , readerIndex_(kCheapPrepend)
+    , writerIndex_(kCheapPrepend)
+    , pool_(nullptr)
+    , readHint_(kInitialSize)
+    , smallReads_(0)
+{
+    buffer_ = allocateBlock(nullptr, kCheapPrepend + initialSize, &capacity_);
+}
+
+Buffer::Buffer(std::shared_ptr<BufferPool> pool)
+    : buffer_(nullptr)
+    , capacity_(0)
+    , readerIndex_(kCheapPrepend)
+    , writerIndex_(kCheapPrepend)
+    , pool_(std::move(pool))
+    , readHint_(kInitialSize)
+    , smallReads_(0)
+{
+}
+
+Buffer::~Buffer()
+{
+    release();
+}
+
+Buffer::Buffer(const Buffer& rhs)
+    : buffer_(nullptr)
+    , capacity_(0)
+    , readerIndex_(kCheapPrepend)
+    , writerIndex_(kCheapPrepend)
+    , pool_(nullptr) // 拷贝出来的Buffer可能在其他线程使用，不使用内存池
+    , readHint_(rhs.readHint_)
+    , smallReads_(0)
+{
+    buffer_ = allocateBlock(nullptr, kCheapPrepend + std::max(rhs.readableBytes(), kInitialSize), &capacity_);
+    append(rhs.peek(), rhs.readableBytes());
+}
+
+Buffer& Buffer::operator=(const Buffer& rhs)
+{
+    if (this != &rhs)
+    {
+        Buffer tmp(rhs);
+        swap(tmp);
+    }
+    return *this;
+}
+
+Buffer::Buffer(Buffer&& rhs) noexcept
+    : buffer_(rhs.buffer_)
+    , capacity_(rhs.capacity_)
+    , readerIndex_(rhs.readerIndex_)
+    , writerIndex_(rhs.writerIndex_)
+    , pool_(std::move(rhs.pool_))
+    , readHint_(rhs.readHint_)
+    , smallReads_(rhs.smallReads_)
+{
+    rhs.buffer_ = nullptr;
+    rhs.capacity_ = 0;
+    rhs.readerIndex_ = kCheapPrepend;
+    rhs.writerIndex_ = kCheapPrepend;
+}
+
+Buffer& Buffer::operator=(Buffer&& rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        Buffer tmp(std::move(rhs));
+        swap(tmp);
+    }
+    return *this;
+}
+
+void Buffer::swap(Buffer& rhs) noexcept
+{
+    std::swap(buffer_, rhs.buffer_);
+    std::swap(capacity_, rhs.capacity_);
+    std::swap(readerIndex_, rhs.readerIndex_);
+    std::swap(writerIndex_, rhs.writerIndex_);
+    std::swap(pool_, rhs.pool_);
+    std::swap(readHint_, rhs.readHint_);
+    std::swap(smallReads_, rhs.smallReads_);
+}
+
+void Buffer::release()
+{
+    if (buffer_)
+    {
+        freeBlock(pool_.get(), buffer_, capacity_);
+        buffer_ = nullptr;
+        capacity_ = 0;
+    }
+}
+
+void Buffer::reallocate(size_t size)
+{
+    size_t readable = readableBytes();
+    size_t actual = 0;
+    char* block = allocateBlock(pool_.get(), size, &actual);
+    if (readable > 0)
+    {
+        memcpy(block + kCheapPrepend, peek(), readable);
+    }
+    release();
+    buffer_ = block;
+    capacity_ = actual;
+    readerIndex_ = kCheapPrepend;
+    writerIndex_ = readerIndex_ + readable;
+}
+
+void Buffer::makeSpace(size_t len)
+{
+    if (buffer_ == nullptr)
+    {
+        reallocate(kCheapPrepend + std::max(len, kInitialSize));
+    }
+    else if (writableBytes() + prependableBytes() < len + kCheapPrepend)
+    {
+        // 只搬移可读的数据，不像vector::resize那样拷贝整块内存
+        // 按数据区翻倍，kCheapPrepend不参与翻倍，否则内存池中会多跳一个等级
+        reallocate(std::max(writerIndex_ + len, kCheapPrepend + (capacity_ - kCheapPrepend) * 2));
+    }
+    else
+    {
+        size_t readable = readableBytes();
+        std::copy(begin() + readerIndex_,
+                  begin() + writerIndex_,
+                  begin() + kCheapPrepend);
+        readerIndex_ = kCheapPrepend;
+        writerIndex_ = readerIndex_ + readable;
+    }
+}
+
+void Buffer::shrinkIfOversized()
+{
+    // 收缩之后还要放得下下一次readFd预留的readHint_，否则大读取时每次都先扩容再收缩；
+    // 持续大读取时readHint_保持在高位不收缩，流量下降之后readHint_减小才收缩
+    const size_t needed = kCheapPrepend + readableBytes() + readHint_;
+    if (pool_ && buffer_
+        && capacity_ - kCheapPrepend > pool_->shrinkWatermark()
+        && needed <= capacity_ / 4)
+    {
+        reallocate(needed);
+    }
+}
+
+// 读取时的溢出区，同一个线程的所有Buffer共用，不需要每次清零
+static __thread char t_extrabuf[Buffer::kMaxReadHint];
+
 /**
  * 从fd上读取数据，Poller工作在LT模式
  * Buffer缓冲区有大小，但是从fd上读数据的时候，却不知道tcp数据最终的大小
+ * 先按照readHint_准备好可写空间，大多数情况下数据直接读到buffer_中；
+ * 放不下的部分读到线程共享的溢出区，再append到buffer_
+ * 使用内存池的Buffer读完之后会归还内存，下次直接从内存池取一块readHint_大小的块来读
 */
 ssize_t Buffer::readFd(int fd, int* savedErrno)
 {
-    char extrabuf[65536] = {0}; // 栈上的内存空间
+    ensureWritableBytes(readHint_);
     iovec vec[2];
     const size_t writable = writableBytes(); // Buffer底层缓冲区剩余可写空间大小
     vec[0].iov_base = begin() + writerIndex_;
     vec[0].iov_len = writable;
-    vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof(extrabuf);
-    const int iovcnt = (writable < sizeof(extrabuf)) ? 2 : 1;
+    vec[1].iov_base = t_extrabuf;
+    vec[1].iov_len = sizeof(t_extrabuf);
+    const int iovcnt = (writable < sizeof(t_extrabuf)) ? 2 : 1;
 
     const ssize_t n = ::readv(fd, vec, iovcnt);
     if (n < 0)
@@ -27,15 +214,39 @@ ssize_t Buffer::readFd(int fd, int* savedErrno)
     else if (n <= writable)
     {
         writerIndex_ += n;
+        adjustReadHint(n, writable);
     }
     else
     {
-        writerIndex_ = buffer_.size();
-        append(extrabuf, n-writable);
+        writerIndex_ = capacity_;
+        append(t_extrabuf, n-writable);
+        adjustReadHint(n, writable);
     }
     return n;
 }
 
+// 读满了可写空间就把预估翻倍；连续几次只用了不到1/4就减半
+void Buffer::adjustReadHint(size_t n, size_t writable)
+{
+    if (n >= writable)
+    {
+        readHint_ = std::min(readHint_ * 2, kMaxReadHint);
+        smallReads_ = 0;
+    }
+    else if (n < readHint_ / 4)
+    {
+        if (++smallReads_ >= kShrinkAfterReads)
+        {
+            readHint_ = std::max(readHint_ / 2, kInitialSize);
+            smallReads_ = 0;
+        }
+    }
+    else
+    {
+        smallReads_ = 0;
+    }
+}
+
 ssize_t Buffer::writeFd(int fd, int* saveErrno)
 {
     ssize_t n = ::write(fd, peek(), readableBytes());
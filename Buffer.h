@@ -1,21 +1,42 @@
 #pragma once
 
-#include <vector>
 #include <string>
 #include <algorithm>
-
+#include <string.h>
+#include <endian.h>
+#include <stdint.h>
+#include <memory>
+#include <sys/types.h>
+
+class BufferPool;
+
+/**
+ * +-------------------+------------------+------------------+
+ * | prependable bytes |  readable bytes  |  writable bytes  |
+ * +-------------------+------------------+------------------+
+ * 0      <=      readerIndex   <=   writerIndex    <=     capacity
+ *
+ * 使用BufferPool的Buffer（TcpConnection的inputBuffer_）在数据读完时把内存还给内存池，
+ * 空闲的连接不占用缓冲区内存，下一次有数据时再从内存池中取
+*/
 class Buffer
 {
 public:
     static const size_t kCheapPrepend = 8;
     static const size_t kInitialSize = 1024;
+    // readFd每次预留的可写空间在[kInitialSize, kMaxReadHint]之间自适应
+    static const size_t kMaxReadHint = 64 * 1024;
 
-    explicit Buffer(size_t initialSize = kInitialSize)
-        : buffer_(kCheapPrepend + initialSize)
-        , readerIndex_(kCheapPrepend)
-        , writerIndex_(kCheapPrepend)
-    {
-    }
+    explicit Buffer(size_t initialSize = kInitialSize);
+    // 内存从pool中申请，构造时不申请；Buffer持有pool，loop先析构也可以安全归还
+    explicit Buffer(std::shared_ptr<BufferPool> pool);
+    ~Buffer();
+
+    Buffer(const Buffer& rhs);
+    Buffer& operator=(const Buffer& rhs);
+    Buffer(Buffer&& rhs) noexcept;
+    Buffer& operator=(Buffer&& rhs) noexcept;
+    void swap(Buffer& rhs) noexcept;
 
     size_t readableBytes() const
     {
@@ -24,7 +45,7 @@ public:
 
     size_t writableBytes() const
     {
-        return buffer_.size() - writerIndex_;
+        return buffer_ ? capacity_ - writerIndex_ : 0;
     }
 
     size_t prependableBytes() const
@@ -32,6 +53,36 @@ public:
         return readerIndex_;
     }
 
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    // 可读数据的起始地址，append等操作可能使之失效，偏移（相对peek）在retrieve之前不变
+    const char* peek() const
+    {
+        return begin() + readerIndex_;
+    }
+
+    // 从start开始查找\r\n，没有时返回nullptr
+    const char* findCRLF(const char* start) const
+    {
+        const char* end = begin() + writerIndex_;
+        for (const char* p = start; p + 1 < end; ++p)
+        {
+            p = static_cast<const char*>(::memchr(p, '\r', end - p - 1));
+            if (p == nullptr)
+            {
+                return nullptr;
+            }
+            if (p[1] == '\n')
+            {
+                return p;
+            }
+        }
+        return nullptr;
+    }
+
     void retrieve(size_t len)
     {
         if (len < readableBytes())
@@ -48,6 +99,10 @@ public:
     {
         readerIndex_ = kCheapPrepend;
         writerIndex_ = kCheapPrepend;
+        if (pool_)
+        {
+            release(); // 读完了，把内存还给内存池
+        }
     }
 
     std::string retrieveAllAsString()
@@ -77,6 +132,44 @@ public:
         writerIndex_ += len;
     }
 
+    // 在可读数据之前写入，len不能超过prependableBytes()
+    void prepend(const void* data, size_t len)
+    {
+        if (buffer_ == nullptr)
+        {
+            makeSpace(0); // 使用内存池的Buffer读完之后没有内存
+        }
+        readerIndex_ -= len;
+        const char* d = static_cast<const char*>(data);
+        std::copy(d, d + len, begin() + readerIndex_);
+    }
+
+    // 以下整数都按网络字节序（大端）读写
+    void appendInt64(int64_t x) { uint64_t be = htobe64(x); append(reinterpret_cast<const char*>(&be), sizeof be); }
+    void appendInt32(int32_t x) { uint32_t be = htobe32(x); append(reinterpret_cast<const char*>(&be), sizeof be); }
+    void appendInt16(int16_t x) { uint16_t be = htobe16(x); append(reinterpret_cast<const char*>(&be), sizeof be); }
+    void appendInt8(int8_t x) { append(reinterpret_cast<const char*>(&x), sizeof x); }
+
+    // 需要readableBytes() >= sizeof(int)
+    int64_t peekInt64() const { uint64_t be; ::memcpy(&be, peek(), sizeof be); return be64toh(be); }
+    int32_t peekInt32() const { uint32_t be; ::memcpy(&be, peek(), sizeof be); return be32toh(be); }
+    int16_t peekInt16() const { uint16_t be; ::memcpy(&be, peek(), sizeof be); return be16toh(be); }
+    int8_t peekInt8() const { return *peek(); }
+
+    int64_t readInt64() { int64_t x = peekInt64(); retrieve(sizeof x); return x; }
+    int32_t readInt32() { int32_t x = peekInt32(); retrieve(sizeof x); return x; }
+    int16_t readInt16() { int16_t x = peekInt16(); retrieve(sizeof x); return x; }
+    int8_t readInt8() { int8_t x = peekInt8(); retrieve(sizeof x); return x; }
+
+    // 需要prependableBytes() >= sizeof(int)，kCheapPrepend保证最多8字节
+    void prependInt64(int64_t x) { uint64_t be = htobe64(x); prepend(&be, sizeof be); }
+    void prependInt32(int32_t x) { uint32_t be = htobe32(x); prepend(&be, sizeof be); }
+    void prependInt16(int16_t x) { uint16_t be = htobe16(x); prepend(&be, sizeof be); }
+    void prependInt8(int8_t x) { prepend(&x, sizeof x); }
+
+    // 容量超过内存池的收缩水位，并且可读数据加上下一次读取的预估不到1/4时，把数据搬到一块合适大小的内存中
+    void shrinkIfOversized();
+
     // 从fd上读取数据
     ssize_t readFd(int fd, int* savedErrno);
     // 写入fd数据
@@ -85,12 +178,12 @@ public:
 private:
     char* begin()
     {
-        return &*buffer_.begin();
+        return buffer_;
     }
 
     const char* begin() const
     {
-        return &*buffer_.begin();
+        return buffer_;
     }
 
     char* beginWrite()
@@ -103,29 +196,19 @@ private:
         return begin() + writerIndex_;
     }
 
-    const char* peek() const
-    {
-        return begin() + readerIndex_;
-    }
+    void makeSpace(size_t len);
+    // 换一块至少size字节的内存，可读的数据搬到新内存的kCheapPrepend处
+    void reallocate(size_t size);
+    void release();
+    void adjustReadHint(size_t n, size_t writable);
 
-    void makeSpace(size_t len)
-    {
-        if (writableBytes() + prependableBytes() < len + kCheapPrepend)
-        {
-            buffer_.resize(writerIndex_ + len);
-        }
-        else
-        {
-            size_t readable = readableBytes();
-            std::copy(begin() + readerIndex_,
-                      begin() + writerIndex_,
-                      begin() + kCheapPrepend);
-            readerIndex_ = kCheapPrepend;
-            writerIndex_ = readerIndex_ + readable;
-        }
-    }
+    static const int kShrinkAfterReads = 4;
 
-    std::vector<char> buffer_;
+    char* buffer_;
+    size_t capacity_;
     size_t readerIndex_;
     size_t writerIndex_;
+    std::shared_ptr<BufferPool> pool_;
+    size_t readHint_; // 预估的单次读取大小，每个连接各自调整
+    int smallReads_; // 连续读到的小数据次数
 };
\ No newline at end of file
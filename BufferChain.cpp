@@ -0,0 +1,207 @@
+#include "BufferChain.h"
+#include "BufferPool.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+namespace
+{
+// 文件段持有的fd，最后一个引用释放时close
+struct FileCloser
+{
+    explicit FileCloser(int fd) : fd_(fd) {}
+    ~FileCloser() { ::close(fd_); }
+    int fd_;
+};
+}
+
+void BufferChain::BlockDeleter::operator()(char* block) const
+{
+    if (pool)
+    {
+        pool->deallocate(block, size);
+    }
+    else
+    {
+        ::free(block);
+    }
+}
+
+BufferChain::BufferChain(std::shared_ptr<BufferPool> pool)
+    : pool_(std::move(pool))
+    , readableBytes_(0)
+{
+}
+
+BufferChain::~BufferChain() = default;
+
+void BufferChain::appendBlock()
+{
+    Segment seg;
+    if (spare_)
+    {
+        seg.block = std::move(spare_);
+    }
+    else if (pool_)
+    {
+        size_t actual = 0;
+        char* block = pool_->allocate(kBlockSize, &actual);
+        seg.block = Block(block, BlockDeleter(pool_.get(), actual));
+    }
+    else
+    {
+        seg.block = Block(static_cast<char*>(::malloc(kBlockSize)), BlockDeleter(nullptr, kBlockSize));
+    }
+    seg.data = seg.block.get();
+    seg.capacity = seg.block.get_deleter().size;
+    segments_.push_back(std::move(seg));
+}
+
+void BufferChain::releaseBlock(Block block)
+{
+    // 有内存池时直接归还，由内存池统一缓存
+    if (!pool_ && !spare_)
+    {
+        spare_ = std::move(block);
+    }
+}
+
+void BufferChain::append(const char* data, size_t len)
+{
+    readableBytes_ += len;
+    while (len > 0)
+    {
+        if (segments_.empty() || segments_.back().writableBytes() == 0)
+        {
+            appendBlock();
+        }
+        Segment& tail = segments_.back();
+        size_t n = len < tail.writableBytes() ? len : tail.writableBytes();
+        memcpy(tail.block.get() + tail.writeIndex, data, n);
+        tail.writeIndex += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void BufferChain::append(std::shared_ptr<const void> owner, const char* data, size_t len)
+{
+    if (len < kMinReferenceSize)
+    {
+        append(data, len);
+        return;
+    }
+    Segment seg;
+    seg.ref = std::move(owner);
+    seg.data = data;
+    seg.writeIndex = len;
+    segments_.push_back(std::move(seg));
+    readableBytes_ += len;
+}
+
+void BufferChain::appendFile(int fd, off_t offset, size_t len)
+{
+    Segment seg;
+    seg.ref = std::make_shared<FileCloser>(fd);
+    seg.fd = fd;
+    seg.readIndex = static_cast<size_t>(offset);
+    seg.writeIndex = static_cast<size_t>(offset) + len;
+    segments_.push_back(std::move(seg));
+    readableBytes_ += len;
+}
+
+void BufferChain::retrieve(size_t len)
+{
+    if (len >= readableBytes_)
+    {
+        retrieveAll();
+        return;
+    }
+    readableBytes_ -= len;
+    while (len > 0)
+    {
+        Segment& head = segments_.front();
+        size_t n = len < head.readableBytes() ? len : head.readableBytes();
+        head.readIndex += n;
+        len -= n;
+        // 只取出一部分数据时，读完的段一定不是最后一段，直接释放
+        if (head.readableBytes() == 0)
+        {
+            if (head.block)
+            {
+                releaseBlock(std::move(head.block));
+            }
+            segments_.pop_front();
+        }
+    }
+}
+
+void BufferChain::retrieveAll()
+{
+    // 没有内存池时保留一个块，下次append不用重新申请
+    for (Segment& seg : segments_)
+    {
+        if (seg.block)
+        {
+            releaseBlock(std::move(seg.block));
+            break;
+        }
+    }
+    segments_.clear();
+    readableBytes_ = 0;
+}
+
+ssize_t BufferChain::writeFd(int fd, int* savedErrno) const
+{
+    if (segments_.empty())
+    {
+        return 0;
+    }
+
+    const Segment& head = segments_.front();
+    if (head.fd >= 0)
+    {
+        off_t offset = static_cast<off_t>(head.readIndex);
+        ssize_t n = ::sendfile(fd, head.fd, &offset, head.readableBytes());
+        if (n < 0)
+        {
+            *savedErrno = errno;
+        }
+        else if (n == 0)
+        {
+            // 文件比调用sendFile时给出的长度短，剩下的数据永远发不出去
+            *savedErrno = ENODATA;
+            n = -1;
+        }
+        return n;
+    }
+
+    // 队首的若干个内存段用一次writev发送，遇到文件段为止
+    iovec vec[IOV_MAX];
+    int iovcnt = 0;
+    for (const Segment& seg : segments_)
+    {
+        if (iovcnt == IOV_MAX || seg.fd >= 0)
+        {
+            break;
+        }
+        if (seg.readableBytes() == 0)
+        {
+            continue;
+        }
+        vec[iovcnt].iov_base = const_cast<char*>(seg.data + seg.readIndex);
+        vec[iovcnt].iov_len = seg.readableBytes();
+        ++iovcnt;
+    }
+    ssize_t n = ::writev(fd, vec, iovcnt);
+    if (n < 0)
+    {
+        *savedErrno = errno;
+    }
+    return n;
+}
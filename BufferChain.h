@@ -0,0 +1,91 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <deque>
+#include <memory>
+#include <sys/types.h>
+
+class BufferPool;
+
+/**
+ * TcpConnection的输出缓冲区：由固定大小的块和引用外部数据的切片组成的链表
+ * append只会往队尾的块写入或者追加新的块，已有的数据不会被搬移，
+ * 不会像Buffer::makeSpace那样在积压很多数据时整体resize和memmove
+ * 较大的外部数据只保存引用（shared_ptr持有生命周期），不拷贝
+ * 还可以追加文件的一段，发送时用sendfile直接从page cache写到socket，不经过用户态
+ * writeFd使用writev，一次最多提交IOV_MAX个iovec；队首是文件段时使用sendfile
+ * 指定了BufferPool时块从内存池申请，发送完立即还给内存池，空闲的连接不持有块
+*/
+class BufferChain : noncopyable
+{
+public:
+    static const size_t kBlockSize = 16 * 1024;
+    // 小于该大小的外部数据直接拷贝到块中，减少iovec的个数
+    static const size_t kMinReferenceSize = 4 * 1024;
+
+    // 为空时块直接从系统申请
+    explicit BufferChain(std::shared_ptr<BufferPool> pool = nullptr);
+    ~BufferChain();
+
+    size_t readableBytes() const { return readableBytes_; }
+    bool empty() const { return readableBytes_ == 0; }
+
+    // 拷贝data到队尾的块中
+    void append(const char* data, size_t len);
+    // 按引用追加外部数据，owner负责保证data在发送完之前有效
+    void append(std::shared_ptr<const void> owner, const char* data, size_t len);
+
+    // 追加文件fd从offset开始的len字节，BufferChain接管fd，发送完或者清空时close
+    void appendFile(int fd, off_t offset, size_t len);
+
+    void retrieve(size_t len);
+    void retrieveAll();
+
+    // 把尽可能多的数据写到fd上
+    ssize_t writeFd(int fd, int* savedErrno) const;
+
+private:
+    // 块归还到申请它的内存池
+    struct BlockDeleter
+    {
+        BlockDeleter() : pool(nullptr), size(0) {}
+        BlockDeleter(BufferPool* p, size_t n) : pool(p), size(n) {}
+
+        BufferPool* pool;
+        size_t size;
+        void operator()(char* block) const;
+    };
+    using Block = std::unique_ptr<char, BlockDeleter>;
+
+    struct Segment
+    {
+        Segment()
+            : data(nullptr)
+            , readIndex(0)
+            , writeIndex(0)
+            , capacity(0)
+            , fd(-1)
+        {
+        }
+
+        Block block; // 自己申请的块，可写
+        std::shared_ptr<const void> ref; // 外部数据或者文件的持有者，只读
+        const char* data;
+        size_t readIndex; // 文件段中表示文件的偏移
+        size_t writeIndex;
+        size_t capacity; // 外部切片为0，不能再写入
+        int fd; // 文件段的fd，内存段为-1
+
+        size_t readableBytes() const { return writeIndex - readIndex; }
+        size_t writableBytes() const { return capacity > writeIndex ? capacity - writeIndex : 0; }
+    };
+
+    void appendBlock();
+    void releaseBlock(Block block);
+
+    std::shared_ptr<BufferPool> pool_; // 在segments_之前声明，最后析构
+    std::deque<Segment> segments_;
+    Block spare_; // 没有内存池时缓存一个发送完的块，避免频繁申请释放
+    size_t readableBytes_;
+};
@@ -0,0 +1,99 @@
+#include "BufferPool.h"
+#include "CurrentThread.h"
+
+#include <stdlib.h>
+
+BufferPool::BufferPool()
+    : threadId_(CurrentThread::tid())
+    , maxCachedBytes_(64 * 1024 * 1024)
+    , shrinkWatermark_(64 * 1024)
+    , bytesInUse_(0)
+    , bytesCached_(0)
+    , blocksInUse_(0)
+{
+}
+
+BufferPool::~BufferPool()
+{
+    trim();
+}
+
+const size_t BufferPool::kBlockHeadroom;
+
+int BufferPool::sizeClass(size_t size)
+{
+    int cls = 0;
+    while (classSize(cls) < size)
+    {
+        ++cls;
+    }
+    return cls;
+}
+
+char* BufferPool::allocate(size_t size, size_t* actual)
+{
+    char* block = nullptr;
+    if (size > classSize(kNumClasses - 1))
+    {
+        *actual = size;
+        block = static_cast<char*>(::malloc(size));
+    }
+    else
+    {
+        int cls = sizeClass(size);
+        *actual = classSize(cls);
+        std::vector<char*>& freeList = freeLists_[cls];
+        if (!freeList.empty())
+        {
+            block = freeList.back();
+            freeList.pop_back();
+            bytesCached_ -= *actual;
+        }
+        else
+        {
+            block = static_cast<char*>(::malloc(*actual));
+        }
+    }
+    bytesInUse_ += *actual;
+    ++blocksInUse_;
+    return block;
+}
+
+void BufferPool::deallocate(char* block, size_t actual)
+{
+    bytesInUse_ -= actual;
+    --blocksInUse_;
+    if (actual > classSize(kNumClasses - 1)
+        || bytesCached_ + actual > maxCachedBytes_
+        || threadId_ != CurrentThread::tid())
+    {
+        ::free(block);
+        return;
+    }
+    freeLists_[sizeClass(actual)].push_back(block);
+    bytesCached_ += actual;
+}
+
+void BufferPool::trim()
+{
+    for (int cls = 0; cls < kNumClasses; ++cls)
+    {
+        for (char* block : freeLists_[cls])
+        {
+            ::free(block);
+        }
+        bytesCached_ -= freeLists_[cls].size() * classSize(cls);
+        freeLists_[cls].clear();
+        freeLists_[cls].shrink_to_fit();
+    }
+}
+
+BufferPool::Stats BufferPool::stats() const
+{
+    Stats stats;
+    stats.bytesInUse = bytesInUse_;
+    stats.bytesCached = bytesCached_;
+    stats.bytesHeld = stats.bytesInUse + stats.bytesCached;
+    stats.blocksInUse = blocksInUse_;
+    return stats;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * 每个EventLoop一个的缓冲区内存池，Buffer和BufferChain的内存都从这里申请
+ * 按2的幂划分大小等级（1KB ~ 1MB），每个等级一个空闲链表，只在loop线程中访问，不加锁
+ * 每个等级的块多kBlockHeadroom字节，Buffer的kCheapPrepend加上2的幂大小的数据正好放进对应的等级
+ * 空闲链表的总大小超过maxCachedBytes时，归还的内存直接还给系统
+ * 超过最大等级的申请直接走malloc，同样计入统计
+ *
+ * 在其他线程中归还的内存（例如连接最后在用户线程中析构）直接free，不进入空闲链表
+ * 由EventLoop在loop线程中创建，Buffer和BufferChain通过shared_ptr持有，loop先析构也不影响归还
+*/
+class BufferPool : noncopyable
+{
+public:
+    struct Stats
+    {
+        size_t bytesHeld; // 从系统申请、当前仍然持有的字节数 = bytesInUse + bytesCached
+        size_t bytesInUse; // 正在被Buffer使用的字节数
+        size_t bytesCached; // 空闲链表中的字节数
+        size_t blocksInUse;
+    };
+
+    static const size_t kMinBlockSize = 1024;
+    static const size_t kMaxBlockSize = 1024 * 1024;
+    static const size_t kBlockHeadroom = 8; // 等于Buffer::kCheapPrepend
+
+    BufferPool();
+    ~BufferPool();
+
+    // 申请至少size字节，实际大小通过actual返回，归还时必须传入actual
+    char* allocate(size_t size, size_t* actual);
+    void deallocate(char* block, size_t actual);
+
+    // 空闲链表最多缓存的字节数
+    void setMaxCachedBytes(size_t bytes) { maxCachedBytes_ = bytes; }
+    // Buffer空闲时的收缩水位：容量超过该值并且大部分空间没有使用的Buffer会换一块小的内存
+    void setShrinkWatermark(size_t bytes) { shrinkWatermark_ = bytes; }
+    size_t shrinkWatermark() const { return shrinkWatermark_; }
+
+    // 把空闲链表中的内存全部还给系统
+    void trim();
+
+    // 线程安全
+    Stats stats() const;
+
+private:
+    static const int kNumClasses = 11; // 1KB, 2KB, ... 1MB
+
+    static int sizeClass(size_t size);
+    static size_t classSize(int cls) { return (kMinBlockSize << cls) + kBlockHeadroom; }
+
+    const pid_t threadId_; // 创建内存池的线程，只有该线程访问空闲链表
+    std::vector<char*> freeLists_[kNumClasses];
+    size_t maxCachedBytes_;
+    size_t shrinkWatermark_;
+
+    std::atomic<size_t> bytesInUse_;
+    std::atomic<size_t> bytesCached_;
+    std::atomic<size_t> blocksInUse_;
+};
@@ -8,6 +8,7 @@
 const int Channel::kNoneEvent = 0;
 const int Channel::kReadEvent = EPOLLIN | EPOLLPRI;
 const int Channel::kWriteEvent = EPOLLOUT;
+const int Channel::kEdgeTriggered = EPOLLET;
 
 Channel::Channel(EventLoop* loop, int fd)
     : loop_(loop)
@@ -15,7 +16,8 @@ Channel::Channel(EventLoop* loop, int fd)
     , events_(0)
     , revents_(0)
     , index_(-1)
-    , tied_(false) 
+    , tied_(false)
+    , edgeTriggered_(false)
 {
 }
 
@@ -39,6 +41,17 @@ void Channel::update()
     loop_->updateChannel(this);
 }
 
+void Channel::setEvents(int events)
+{
+    const int registered = this->events();
+    events_ = events;
+    // 边缘触发模式下注册的事件没有变化（只是开关写事件）时不需要epoll_ctl
+    if (!edgeTriggered_ || this->events() != registered)
+    {
+        update();
+    }
+}
+
 // 在所属的EventLoop，把当前的Channel删除掉
 void Channel::remove()
 {
@@ -84,7 +97,8 @@ void Channel::handleEventWithGuard(Timestamp receiveTime)
         if (readCallback_) { readCallback_(receiveTime); }
     }
 
-    if (revents_ & EPOLLOUT)
+    // 边缘触发模式下EPOLLOUT一直注册着，没有待发送的数据时忽略
+    if ((revents_ & EPOLLOUT) && (!edgeTriggered_ || isWriting()))
     {
         if (writeCallback_) { writeCallback_(); }
     }
@@ -2,8 +2,10 @@
 
 #include <functional>
 #include <memory>
+#include <string>
 
 #include "noncopyable.h"
+#include "InplaceFunction.h"
 
 class EventLoop; //类型的前置声明
 class Timestamp;
@@ -14,8 +16,8 @@ class Timestamp;
 */
 class Channel : noncopyable {
 public:
-    using EventCallback = std::function<void()>;
-    using ReadEventCallback = std::function<void(Timestamp)>;
+    using EventCallback = InplaceFunction<void()>;
+    using ReadEventCallback = InplaceFunction<void(Timestamp)>;
 
     Channel(EventLoop* loop, int fd);
     ~Channel();
@@ -40,18 +42,38 @@ public:
     void tie(const std::shared_ptr<void>&);
 
     int fd() const { return fd_; }
-    int events() const { return events_; }
+    // 注册到Poller的事件
+    int events() const
+    {
+        return (edgeTriggered_ && events_ != kNoneEvent)
+            ? events_ | kWriteEvent | kEdgeTriggered
+            : events_;
+    }
+    int revents() const { return revents_; }
     void set_revents(int revt) { revents_ = revt; }
+
+    // 诊断用的名字，例如连接名，慢回调和卡顿的报告中会带上
+    void setName(const std::string& name) { name_ = name; }
+    const std::string& name() const { return name_; }
     bool isNoneEvent() const { return events_ == kNoneEvent; }
     bool isWriting() const { return events_ & kWriteEvent; }
     bool isReading() const { return events_ & kReadEvent; }
 
     // 设置fd相应的事件状态
-    void enableReading() { events_ |= kReadEvent; update(); }
-    void disableReading() { events_ &= ~kReadEvent; update(); }
-    void enableWriting() { events_ |= kWriteEvent; update(); }
-    void disableWriting() { events_ &= ~kReadEvent; update(); }
-    void disableAll() { events_ = kNoneEvent; update(); }
+    void enableReading() { setEvents(events_ | kReadEvent); }
+    void disableReading() { setEvents(events_ & ~kReadEvent); }
+    void enableWriting() { setEvents(events_ | kWriteEvent); }
+    void disableWriting() { setEvents(events_ & ~kWriteEvent); }
+    void disableAll() { setEvents(kNoneEvent); }
+
+    /**
+     * 边缘触发模式，需要在enableReading之前设置
+     * 只要有感兴趣的事件，就连同EPOLLOUT|EPOLLET一起注册到Poller，
+     * enableWriting/disableWriting只改变isWriting()，不再调用epoll_ctl，
+     * 没有在写的时候Poller通知的EPOLLOUT直接忽略
+    */
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    bool edgeTriggered() const { return edgeTriggered_; }
 
     int index() const { return index_; }
     void set_index(int idx) { index_ = idx; }
@@ -61,20 +83,25 @@ public:
 
 private:
     void update();
+    void setEvents(int events);
     void handleEventWithGuard(Timestamp reveiveTime);
 
     static const int kNoneEvent;
     static const int kReadEvent;
     static const int kWriteEvent;
+    static const int kEdgeTriggered;
 
     EventLoop* loop_;
     const int fd_; // 文件描述符, Poller监听的对象
-    int events_; // 注册fd感兴趣的事件
+    int events_; // 注册fd感兴趣的事件，边缘触发模式下实际注册的事件见events()
     int revents_; // Poller返回的具体发生的事件
     int index_;
 
+    std::string name_;
+
     std::weak_ptr<void> tie_;
     bool tied_;
+    bool edgeTriggered_;
 
     // Channel通道能够获得fd最终发生的事件，所以它负责调用具体事件的回调操作
     ReadEventCallback readCallback_;
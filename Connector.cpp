@@ -0,0 +1,244 @@
+#include "Connector.h"
+#include "Channel.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+static int createNonblocking()
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sockfd < 0)
+    {
+        LOG_FATAL("%s:%s:%d Connector::createNonblocking error %d \n", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
+    return sockfd;
+}
+
+static int getSocketError(int sockfd)
+{
+    int optval = 0;
+    socklen_t optlen = sizeof optval;
+    if (::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0)
+    {
+        return errno;
+    }
+    return optval;
+}
+
+// 连接本机上没有监听的端口时，内核可能选中同一个端口作为本端，自己连上自己
+static bool isSelfConnect(int sockfd)
+{
+    sockaddr_in local;
+    sockaddr_in peer;
+    socklen_t len = sizeof local;
+    bzero(&local, sizeof local);
+    bzero(&peer, sizeof peer);
+    if (::getsockname(sockfd, (sockaddr*)&local, &len) < 0)
+    {
+        return false;
+    }
+    len = sizeof peer;
+    if (::getpeername(sockfd, (sockaddr*)&peer, &len) < 0)
+    {
+        return false;
+    }
+    return local.sin_port == peer.sin_port && local.sin_addr.s_addr == peer.sin_addr.s_addr;
+}
+
+Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
+    : loop_(loop)
+    , serverAddr_(serverAddr)
+    , connect_(false)
+    , state_(kDisconnected)
+    , initRetryDelayMs_(kInitRetryDelayMs)
+    , maxRetryDelayMs_(kMaxRetryDelayMs)
+    , retryDelayMs_(kInitRetryDelayMs)
+{
+    LOG_DEBUG("Connector ctor[%p]\n", this);
+}
+
+Connector::~Connector()
+{
+    LOG_DEBUG("Connector dtor[%p]\n", this);
+}
+
+void Connector::setRetryDelay(int initMs, int maxMs)
+{
+    initRetryDelayMs_ = initMs > 0 ? initMs : 1;
+    maxRetryDelayMs_ = maxMs > initRetryDelayMs_ ? maxMs : initRetryDelayMs_;
+    retryDelayMs_ = initRetryDelayMs_;
+}
+
+void Connector::start()
+{
+    connect_ = true;
+    loop_->runInLoop(std::bind(&Connector::startInLoop, shared_from_this()));
+}
+
+void Connector::restart()
+{
+    setState(kDisconnected);
+    retryDelayMs_ = initRetryDelayMs_;
+    connect_ = true;
+    startInLoop();
+}
+
+void Connector::stop()
+{
+    connect_ = false;
+    loop_->queueInLoop(std::bind(&Connector::stopInLoop, shared_from_this()));
+}
+
+void Connector::startInLoop()
+{
+    if (connect_ && state_ == kDisconnected)
+    {
+        connect();
+    }
+    else
+    {
+        LOG_DEBUG("Connector::startInLoop do not connect\n");
+    }
+}
+
+void Connector::stopInLoop()
+{
+    loop_->cancel(retryTimer_);
+    retryTimer_ = TimerId();
+    if (state_ == kConnecting)
+    {
+        setState(kDisconnected);
+        int sockfd = removeAndResetChannel();
+        ::close(sockfd);
+    }
+}
+
+void Connector::connect()
+{
+    int sockfd = createNonblocking();
+    const sockaddr_in* addr = serverAddr_.getSockAddr();
+    int ret = ::connect(sockfd, (const sockaddr*)addr, sizeof(sockaddr_in));
+    int savedErrno = (ret == 0) ? 0 : errno;
+    switch (savedErrno)
+    {
+    case 0:
+    case EINPROGRESS:
+    case EINTR:
+    case EISCONN:
+        connecting(sockfd);
+        break;
+
+    // 暂时性的错误，稍后重试
+    case EAGAIN:
+    case EADDRINUSE:
+    case EADDRNOTAVAIL:
+    case ECONNREFUSED:
+    case ENETUNREACH:
+    case EHOSTUNREACH:
+    case ETIMEDOUT:
+        retry(sockfd);
+        break;
+
+    default:
+        LOG_ERROR("Connector::connect to %s error %d \n", serverAddr_.toIpPort().c_str(), savedErrno);
+        ::close(sockfd);
+        setState(kDisconnected);
+        connect_ = false;
+        // 回调中可能释放持有Connector的指针，调用者绑定了shared_from_this
+        if (errorCallback_)
+        {
+            errorCallback_(savedErrno);
+        }
+        break;
+    }
+}
+
+// 等待sockfd可写，即连接完成（成功或失败）
+void Connector::connecting(int sockfd)
+{
+    setState(kConnecting);
+    channel_.reset(new Channel(loop_, sockfd));
+    channel_->setName("Connector " + serverAddr_.toIpPort());
+    channel_->setWriteCallback(std::bind(&Connector::handleWrite, this));
+    channel_->setErrorCallback(std::bind(&Connector::handleError, this));
+    channel_->enableWriting();
+}
+
+// 不能在Channel的回调中销毁Channel，放到这一轮事件处理之后
+int Connector::removeAndResetChannel()
+{
+    channel_->disableAll();
+    channel_->remove();
+    int sockfd = channel_->fd();
+    loop_->queueInLoop(std::bind(&Connector::resetChannel, shared_from_this()));
+    return sockfd;
+}
+
+void Connector::resetChannel()
+{
+    channel_.reset();
+}
+
+void Connector::handleWrite()
+{
+    if (state_ != kConnecting)
+    {
+        return;
+    }
+    int sockfd = removeAndResetChannel();
+    int err = getSocketError(sockfd);
+    if (err)
+    {
+        LOG_ERROR("Connector::handleWrite %s - SO_ERROR = %d %s \n", serverAddr_.toIpPort().c_str(), err, strerror(err));
+        retry(sockfd);
+    }
+    else if (isSelfConnect(sockfd))
+    {
+        LOG_ERROR("Connector::handleWrite - Self connect \n");
+        retry(sockfd);
+    }
+    else
+    {
+        setState(kConnected);
+        if (connect_ && newConnectionCallback_)
+        {
+            newConnectionCallback_(sockfd);
+        }
+        else
+        {
+            ::close(sockfd);
+        }
+    }
+}
+
+void Connector::handleError()
+{
+    if (state_ == kConnecting)
+    {
+        int sockfd = removeAndResetChannel();
+        int err = getSocketError(sockfd);
+        LOG_ERROR("Connector::handleError %s - SO_ERROR = %d %s \n", serverAddr_.toIpPort().c_str(), err, strerror(err));
+        retry(sockfd);
+    }
+}
+
+// 关闭这次的sockfd，retryDelayMs_之后重新connect，间隔每次翻倍
+void Connector::retry(int sockfd)
+{
+    ::close(sockfd);
+    setState(kDisconnected);
+    if (connect_)
+    {
+        LOG_INFO("Connector::retry - Retry connecting to %s in %d milliseconds. \n",
+            serverAddr_.toIpPort().c_str(), retryDelayMs_);
+        retryTimer_ = loop_->runAfter(retryDelayMs_ / 1000.0,
+            std::bind(&Connector::startInLoop, shared_from_this()));
+        retryDelayMs_ = std::min(retryDelayMs_ * 2, maxRetryDelayMs_);
+    }
+}
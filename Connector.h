@@ -0,0 +1,71 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "InetAddress.h"
+#include "TimerId.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class Channel;
+class EventLoop;
+
+/**
+ * 主动发起连接，和Acceptor相对：非阻塞connect，Channel关注EPOLLOUT，可写时用SO_ERROR判断是否成功
+ * 失败后按指数退避重试（初始0.5秒，每次翻倍，最多30秒），连接成功后把sockfd交给newConnectionCallback
+ * connect返回EACCES、ENETDOWN这类重试也没用的错误时不再重试，回调errorCallback
+ * 由TcpClient使用，通过shared_ptr管理，重试的定时器持有它
+*/
+class Connector : noncopyable, public std::enable_shared_from_this<Connector>
+{
+public:
+    using NewConnectionCallback = std::function<void(int sockfd)>;
+    using ErrorCallback = std::function<void(int err)>;
+
+    static const int kInitRetryDelayMs = 500;
+    static const int kMaxRetryDelayMs = 30 * 1000;
+
+    Connector(EventLoop* loop, const InetAddress& serverAddr);
+    ~Connector();
+
+    void setNewConnectionCallback(const NewConnectionCallback& cb) { newConnectionCallback_ = cb; }
+    // 放弃连接时回调，参数是connect的errno；之后需要重新start
+    void setErrorCallback(const ErrorCallback& cb) { errorCallback_ = cb; }
+    // 重试的初始间隔和最大间隔，单位毫秒，需要在start之前设置
+    void setRetryDelay(int initMs, int maxMs);
+
+    const InetAddress& serverAddress() const { return serverAddr_; }
+
+    void start(); // 可以跨线程调用
+    void restart(); // 只能在loop线程中调用，连接断开之后重新开始，重试间隔从头开始
+    void stop(); // 可以跨线程调用
+
+private:
+    enum StateE { kDisconnected, kConnecting, kConnected };
+
+    void setState(StateE state) { state_ = state; }
+    void startInLoop();
+    void stopInLoop();
+    void connect();
+    void connecting(int sockfd);
+    void handleWrite();
+    void handleError();
+    void retry(int sockfd);
+    int removeAndResetChannel();
+    void resetChannel();
+
+    EventLoop* loop_;
+    InetAddress serverAddr_;
+    std::atomic_bool connect_; // start之后为true，stop之后为false
+    std::atomic_int state_;
+    std::unique_ptr<Channel> channel_; // 正在连接的sockfd，连接成功或失败之后销毁
+    NewConnectionCallback newConnectionCallback_;
+    ErrorCallback errorCallback_;
+    int initRetryDelayMs_;
+    int maxRetryDelayMs_;
+    int retryDelayMs_;
+    TimerId retryTimer_;
+};
+
+using ConnectorPtr = std::shared_ptr<Connector>;
@@ -8,7 +8,7 @@ namespace CurrentThread
     {
         if (t_cachedTid == 0)
         {
-            t_cachedTid = static_cast<pid_t>(::syscall(SYS_getpid));
+            t_cachedTid = static_cast<pid_t>(::syscall(SYS_gettid));
         }
     }
 }
\ No newline at end of file
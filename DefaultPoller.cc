@@ -1,16 +1,46 @@
 #include "Poller.h"
 #include "EPollPoller.h"
+#include "PollPoller.h"
+#include "IoUringPoller.h"
+#include "Logger.h"
 
 #include <stdlib.h>
 
 Poller* Poller::newDefaultPoller(EventLoop* loop)
 {
-    if (::getenv("MUDUO_USE_POLL"))
+    return newPoller(loop, kDefault);
+}
+
+Poller* Poller::newPoller(EventLoop* loop, Backend backend)
+{
+    if (backend == kDefault)
+    {
+        if (::getenv("MUDUO_USE_POLL"))
+        {
+            backend = kPoll;
+        }
+        else if (::getenv("MUDUO_USE_IO_URING"))
+        {
+            backend = kIoUring;
+        }
+        else
+        {
+            backend = kEPoll;
+        }
+    }
+
+    if (backend == kPoll)
     {
-        return nullptr;
+        return new PollPoller(loop);
     }
-    else
+
+    if (backend == kIoUring)
     {
-        return new EPollPoller(loop);
+        if (IoUringPoller::isSupported())
+        {
+            return new IoUringPoller(loop);
+        }
+        LOG_INFO("io_uring is not supported by the kernel, fall back to epoll\n");
     }
-}
\ No newline at end of file
+    return new EPollPoller(loop);
+}
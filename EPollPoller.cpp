@@ -27,7 +27,7 @@ EPollPoller::~EPollPoller()
 
 Timestamp EPollPoller::poll(int timeousMs, ChannelList* activechannels)
 {
-    LOG_DEBUG("func=%s, fd total count:%d\n", __FUNCTION__, channels_.size());
+    LOG_DEBUG("func=%s, fd total count:%zu\n", __FUNCTION__, channels_.size());
     int numEvents = ::epoll_wait(epollfd_, &*events_.begin(), static_cast<int>(events_.size()), timeousMs);
     int savedErrno = errno;
     Timestamp now(Timestamp::now());
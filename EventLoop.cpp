@@ -2,6 +2,9 @@
 #include "Logger.h"
 #include "Poller.h"
 #include "Channel.h"
+#include "TimerQueue.h"
+#include "TimingWheel.h"
+#include "BufferPool.h"
 
 #include <sys/eventfd.h>
 #include <unistd.h>
@@ -24,15 +27,22 @@ int createEventfd()
     return evtfd;
 }
 
-EventLoop::EventLoop()
+EventLoop::EventLoop(Poller::Backend backend)
     : looping_(false)
     , quit_(false)
     , callingPendingFunctors_(false)
     , threadId_(CurrentThread::tid()) 
-    , poller_(Poller::newDefaultPoller(this))
+    , bufferPool_(std::make_shared<BufferPool>())
+    , poller_(Poller::newPoller(this, backend))
+    , timerQueue_(new TimerQueue(this))
     , wakeupfd_(createEventfd())
     , wakeupChannel_(new Channel(this, wakeupfd_))
     , currentActiveChannel_(nullptr)
+    , wakeupPending_(false)
+    , trackActivity_(false)
+    , callbackBudgetNanos_(0)
+    , numConnections_(0)
+    , pendingBytes_(0)
 {
     LOG_DEBUG("EventLoop created %p in thread %d \n", this, threadId_);
     if (t_loopInThisThread)
@@ -44,6 +54,7 @@ EventLoop::EventLoop()
         t_loopInThisThread = this;
     }
     // 设置wakeupfd的事件类型以及发生事件后的回调操作
+    wakeupChannel_->setName("wakeup");
     wakeupChannel_->setReadEventCallback(std::bind(&EventLoop::handleRead, this));
     // 每一个EventLoop都将监听wakeupChannel的EPOLLIN事件
     wakeupChannel_->enableReading();
@@ -64,15 +75,42 @@ void EventLoop::loop()
 
     LOG_INFO("EventLoop %p start looping \n", this);
 
+    // 相邻的两次计时首尾相接，每个阶段只多读一次时钟
+    uint64_t last = LoopMetrics::nowNanos();
     while (!quit_)
     {
+        const bool tracking = trackActivity_.load(std::memory_order_relaxed);
+        const uint64_t budget = tracking ? callbackBudgetNanos_.load(std::memory_order_relaxed) : 0;
         activeChannels_.clear();
+        if (tracking)
+        {
+            activity_.setIterationStart(0);
+        }
         // 监听两类fd，一种是client的fd，一种是wakeup的fd
         pollReturnTime_ = poller_->poll(kPollTime, &activeChannels_);
+        uint64_t now = LoopMetrics::nowNanos();
+        metrics_.recordPoll(now - last, activeChannels_.size());
+        last = now;
+        if (tracking)
+        {
+            activity_.setIterationStart(now);
+        }
         for (Channel* channel : activeChannels_)
         {
             currentActiveChannel_ = channel;
+            if (tracking)
+            {
+                // 回调返回之后channel可能已经析构，需要的信息先记下来
+                activity_.begin(last, channel->fd(), channel->revents(), channel->name());
+            }
             currentActiveChannel_->handleEvent(pollReturnTime_);
+            now = LoopMetrics::nowNanos();
+            metrics_.recordHandleEvent(now - last);
+            if (budget > 0 && now - last > budget)
+            {
+                reportSlowCallback(now - last);
+            }
+            last = now;
         }
         // 执行当前EventLoop需要处理的回调操作
         /**
@@ -80,7 +118,13 @@ void EventLoop::loop()
          * mainLoop事先注册一个回调，需要subloop执行，即通过wakeup唤醒subloop
          * subloop执行mainloop注册的回调函数，即下面的方法
         */
-        doPendingFunctors();
+        size_t functors = doPendingFunctors();
+        now = LoopMetrics::nowNanos();
+        if (functors > 0)
+        {
+            metrics_.recordFunctors(functors, now - last);
+        }
+        last = now;
     }
     LOG_INFO("EventLoop %p stop looping. \n", this);
     looping_ = false;
@@ -116,19 +160,49 @@ void EventLoop::runInLoop(Functor cb)
 
 void EventLoop::queueInLoop(Functor cb)
 {
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        pendingFunctors_.emplace_back(cb);
-    }
+    pendingFunctors_.push(std::move(cb));
 
     // 唤醒相应的，需要执行上面回调操作的loop的线程
     // 在上一轮回调还在执行时，就进行唤醒操作
-    if (!isInLoopThread() || callingPendingFunctors_)
+    // 多个线程连续投递时只有第一个写eventfd，直到loop在doPendingFunctors中清除标志
+    if ((!isInLoopThread() || callingPendingFunctors_)
+        && !wakeupPending_.exchange(true))
     {
         wakeup(); // 唤醒loop所在线程
     }
 }
 
+TimerId EventLoop::runAt(Timestamp time, TimerCallback cb)
+{
+    return timerQueue_->addTimer(std::move(cb), time, 0.0);
+}
+
+TimerId EventLoop::runAfter(double delay, TimerCallback cb)
+{
+    Timestamp time(addTime(Timestamp::now(), delay));
+    return runAt(time, std::move(cb));
+}
+
+TimerId EventLoop::runEvery(double interval, TimerCallback cb)
+{
+    Timestamp time(addTime(Timestamp::now(), interval));
+    return timerQueue_->addTimer(std::move(cb), time, interval);
+}
+
+void EventLoop::cancel(TimerId timerId)
+{
+    timerQueue_->cancel(timerId);
+}
+
+TimingWheel* EventLoop::timingWheel()
+{
+    if (!timingWheel_)
+    {
+        timingWheel_.reset(new TimingWheel(this));
+    }
+    return timingWheel_.get();
+}
+
 // wakeup向wakeupfd写一个数据，wakeupchannel发生读事件，subloop会被唤醒
 void EventLoop::wakeup()
 {
@@ -150,6 +224,23 @@ void EventLoop::handleRead()
     }
 }
 
+void EventLoop::setCallbackBudget(double seconds)
+{
+    if (seconds > 0)
+    {
+        enableActivityTracking();
+    }
+    callbackBudgetNanos_.store(seconds > 0 ? static_cast<uint64_t>(seconds * 1e9) : 0, std::memory_order_relaxed);
+}
+
+void EventLoop::reportSlowCallback(uint64_t nanos)
+{
+    LoopActivity::Snapshot activity = activity_.snapshot();
+    LOG_ERROR("EventLoop %p slow %s callback of fd=%d [%s] took %.3f ms, budget %.3f ms \n",
+        this, activity.callbackType().c_str(), activity.fd, activity.name,
+        nanos / 1e6, callbackBudgetNanos_.load(std::memory_order_relaxed) / 1e6);
+}
+
 void EventLoop::removeChannel(Channel* channel)
 {
     poller_->removeChannel(channel);
@@ -165,17 +256,47 @@ bool EventLoop::hasChannel(Channel* channel)
     return poller_->hasChannel(channel);
 }
 
-void EventLoop::doPendingFunctors()
+bool EventLoop::enableMultishotAccept(Channel* channel)
+{
+    return poller_->enableMultishotAccept(channel);
+}
+
+bool EventLoop::takeAccepted(Channel* channel, std::vector<int>* fds)
+{
+    return poller_->takeAccepted(channel, fds);
+}
+
+size_t EventLoop::doPendingFunctors()
 {
-    std::vector<Functor> functors;
     callingPendingFunctors_ = true;
+    // 先清除标志再取队列：清除之后入队的回调一定会重新唤醒loop，不会被遗漏
+    wakeupPending_.store(false);
+    size_t n = 0;
+    if (!trackActivity_.load(std::memory_order_relaxed))
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        functors.swap(pendingFunctors_);
+        n = pendingFunctors_.consumeAll([](Functor&& functor) {
+            functor(); // 执行当前loop需要执行的回调操作
+        });
     }
-    for (const Functor& functor : functors)
+    else
     {
-        functor(); // 执行当前loop需要执行的回调操作
+        // 逐个计时，看门狗可以看到卡在回调上
+        static const std::string kNoName;
+        const uint64_t budget = callbackBudgetNanos_.load(std::memory_order_relaxed);
+        n = pendingFunctors_.consumeAll([this, budget](Functor&& functor) {
+            uint64_t start = LoopMetrics::nowNanos();
+            activity_.begin(start, -1, LoopActivity::kPendingFunctor, kNoName);
+            functor();
+            if (budget > 0)
+            {
+                uint64_t elapsed = LoopMetrics::nowNanos() - start;
+                if (elapsed > budget)
+                {
+                    reportSlowCallback(elapsed);
+                }
+            }
+        });
     }
     callingPendingFunctors_ = false;
+    return n;
 }
\ No newline at end of file
@@ -3,23 +3,33 @@
 #include "noncopyable.h"
 #include "Timestamp.h"
 #include "CurrentThread.h"
+#include "Callback.h"
+#include "TimerId.h"
+#include "MpscQueue.h"
+#include "InplaceFunction.h"
+#include "Poller.h"
+#include "LoopMetrics.h"
+#include "LoopActivity.h"
 
 #include <functional>
 #include <vector>
 #include <atomic>
 #include <memory>
-#include <mutex>
 
 class Channel;
-class Poller;
+class TimerQueue;
+class TimingWheel;
+class BufferPool;
 
 // 时间循环类，包括两大模块 Channel Poller
 class EventLoop : noncopyable 
 {
 public:
-    using Functor = std::function<void()>;
+    // 只能移动，bind一个成员函数指针和shared_ptr等小对象时不申请堆内存
+    using Functor = InplaceFunction<void()>;
 
-    EventLoop();
+    // backend选择IO复用的实现，默认由环境变量决定
+    explicit EventLoop(Poller::Backend backend = Poller::kDefault);
     ~EventLoop();
 
     // 开启事件循环
@@ -37,10 +47,48 @@ public:
     // 用来唤醒loop所在的线程
     void wakeup();
 
+    // 定时器，回调都在loop所在的线程中执行，可以跨线程调用
+    // 在time时刻执行cb
+    TimerId runAt(Timestamp time, TimerCallback cb);
+    // delay秒之后执行cb
+    TimerId runAfter(double delay, TimerCallback cb);
+    // 每隔interval秒执行一次cb
+    TimerId runEvery(double interval, TimerCallback cb);
+    // 取消定时器
+    void cancel(TimerId timerId);
+
+    // 空闲连接的时间轮，第一次使用时创建，只能在loop线程中调用
+    TimingWheel* timingWheel();
+
+    // 本loop的缓冲区内存池，只在loop线程中缓存归还的内存，stats()可以跨线程调用
+    // 使用内存池的Buffer各自持有一份，最后一个连接在loop之后析构也可以安全归还
+    const std::shared_ptr<BufferPool>& bufferPool() const { return bufferPool_; }
+
+    // 负载统计：连接数和输出缓冲区中待发送的字节数，由TcpConnection维护，可以跨线程读
+    // EventLoopThreadPool据此为新连接选择loop
+    int numConnections() const { return numConnections_.load(std::memory_order_relaxed); }
+    int64_t pendingBytes() const { return pendingBytes_.load(std::memory_order_relaxed); }
+    void addConnections(int n) { numConnections_.fetch_add(n, std::memory_order_relaxed); }
+    void addPendingBytes(int64_t n) { pendingBytes_.fetch_add(n, std::memory_order_relaxed); }
+
+    // 运行统计，loop线程记录，snapshot可以跨线程调用
+    LoopMetrics& metrics() { return metrics_; }
+    const LoopMetrics& metrics() const { return metrics_; }
+
+    // 单个Channel回调或者pendingFunctor超过seconds秒时记录ERROR日志（fd、名字、回调类型、耗时）
+    // 0表示不检查，可以跨线程调用；开启后每个回调多读一次时钟
+    void setCallbackBudget(double seconds);
+    // 记录当前正在执行的回调，供LoopWatchdog读取，可以跨线程调用
+    void enableActivityTracking() { trackActivity_.store(true, std::memory_order_relaxed); }
+    const LoopActivity& activity() const { return activity_; }
+
     // EventLoop的方法 -> Poler的方法
     void updateChannel(Channel* channel);
     void removeChannel(Channel* channel);
     bool hasChannel(Channel* channel);
+    // 完成式accept，见Poller::enableMultishotAccept，只能在loop线程中调用
+    bool enableMultishotAccept(Channel* channel);
+    bool takeAccepted(Channel* channel, std::vector<int>* fds);
 
     // 判断EventLoop的对象是否在自己的线程里面
     bool isInLoopThread() const { return threadId_ == CurrentThread::tid(); }
@@ -48,8 +96,9 @@ public:
 private:
     // wake up
     void handleRead();
-    // 执行回调
-    void doPendingFunctors();
+    // 执行回调，返回执行的个数
+    size_t doPendingFunctors();
+    void reportSlowCallback(uint64_t nanos);
 
     using ChannelList = std::vector<Channel*>;
     std::atomic_bool looping_; // 原子操作，通过CAS实现
@@ -59,13 +108,23 @@ private:
     const pid_t threadId_; // 记录当前loop所在线程的id
 
     Timestamp pollReturnTime_; // 记录Poller返回发生事件的Channels的时间点
+    std::shared_ptr<BufferPool> bufferPool_;
     std::unique_ptr<Poller> poller_;
+    std::unique_ptr<TimerQueue> timerQueue_; // 基于timerfd的定时器队列
+    std::unique_ptr<TimingWheel> timingWheel_; // 空闲连接超时的时间轮
 
     int wakeupfd_; // 主要作用：当mainLoop获取一个新用户的Channel通过轮询算法选择一个subloop，通过该成员唤醒subloop处理channel
     std::unique_ptr<Channel> wakeupChannel_;
 
     ChannelList activeChannels_;
     Channel* currentActiveChannel_;
-    std::vector<Functor> pendingFunctors_; // 存贮loop需要执行的所有的回调操作
-    std::mutex mutex_; // 互斥锁，用来保护上面vector容器的线程安全操作
+    MpscQueue<Functor> pendingFunctors_; // 存贮loop需要执行的所有的回调操作，无锁，其他线程只push
+    std::atomic_bool wakeupPending_; // 已经写过wakeupfd但loop还没有处理，期间的queueInLoop不再重复唤醒
+
+    LoopMetrics metrics_;
+    LoopActivity activity_;
+    std::atomic_bool trackActivity_;
+    std::atomic<uint64_t> callbackBudgetNanos_;
+    std::atomic<int> numConnections_;
+    std::atomic<int64_t> pendingBytes_;
 };
\ No newline at end of file
@@ -1,14 +1,34 @@
 #include "EventLoopThread.h"
 #include "EventLoop.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// <numaif.h>中的MPOL_LOCAL，直接用系统调用，不依赖libnuma
+const int kMpolLocal = 4;
+
+// 线程之后申请的内存优先从当前CPU所在的NUMA节点分配，
+// 即使进程被numactl --interleave之类的策略启动，绑核的loop线程也使用本地内存
+static void useLocalNumaNode()
+{
+    if (::syscall(SYS_set_mempolicy, kMpolLocal, nullptr, 0) < 0 && errno != ENOSYS)
+    {
+        LOG_ERROR("%s:%s:%d set_mempolicy error:%d \n", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
+}
 
 EventLoopThread::EventLoopThread(const ThreadInitCallback& cb,
-        const std::string& name)
+        const std::string& name,
+        Poller::Backend backend)
         : loop_(nullptr)
         , exiting_(false)
         , thread_(std::bind(&EventLoopThread::threadFunc, this), name)
         , mutex_()
         , cond_()
         , callback_(cb)
+        , backend_(backend)
 {
 
 }
@@ -43,7 +63,13 @@ EventLoop* EventLoopThread::startLoop()
 // 单独在新线程运行的内容
 void EventLoopThread::threadFunc()
 {
-    EventLoop loop; // 创建一个独立的eventloop，和上面的线程是一一对应的，one loop per thread
+    // 线程已经绑核，在创建EventLoop之前设置内存策略
+    if (!thread_.cpuAffinity().empty())
+    {
+        useLocalNumaNode();
+    }
+
+    EventLoop loop(backend_); // 创建一个独立的eventloop，和上面的线程是一一对应的，one loop per thread
 
     if (callback_)
     {
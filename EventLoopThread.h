@@ -4,9 +4,11 @@
 #include <mutex>
 #include <condition_variable>
 #include <string>
+#include <vector>
 
 #include "noncopyable.h"
 #include "Thread.h"
+#include "Poller.h"
 
 class EventLoop;
 
@@ -16,9 +18,14 @@ public:
     using ThreadInitCallback = std::function<void(EventLoop*)>;
 
     EventLoopThread(const ThreadInitCallback& cb = ThreadInitCallback(),
-                    const std::string& name = std::string());
+                    const std::string& name = std::string(),
+                    Poller::Backend backend = Poller::kDefault);
     ~EventLoopThread();
 
+    // loop线程绑定到cpus上，loop自己的内存（Poller的事件数组、缓冲区等）从所在的NUMA节点分配
+    // 需要在startLoop之前设置
+    void setCpuAffinity(const std::vector<int>& cpus) { thread_.setCpuAffinity(cpus); }
+
     EventLoop* startLoop();
 
 private:
@@ -30,4 +37,5 @@ private:
     std::mutex mutex_;
     std::condition_variable cond_;
     ThreadInitCallback callback_;
+    Poller::Backend backend_;
 };
\ No newline at end of file
@@ -9,6 +9,8 @@ EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseloop, const std::string&
     , started_(false)
     , numThreads_(0)
     , next_(0)
+    , backend_(Poller::kDefault)
+    , policy_(LoadBalancer::kRoundRobin)
 {
 }
 
@@ -24,11 +26,21 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb)
     {
         char buf[name_.size() + 32];
         snprintf(buf, sizeof(buf), "%s%d", name_.c_str(), i);
-        EventLoopThread* t = new EventLoopThread(cb, buf);
+        EventLoopThread* t = new EventLoopThread(cb, buf, backend_);
+        if (!cpus_.empty())
+        {
+            t->setCpuAffinity(std::vector<int>(1, cpus_[i % cpus_.size()]));
+        }
         threads_.push_back(std::unique_ptr<EventLoopThread>(t));
         loops_.push_back(t->startLoop()); // 底层创建线程，绑定一个新的EventLoop，并返回loop的地址
     }
 
+    if (!loops_.empty())
+    {
+        balancer_ = LoadBalancer::newBalancer(policy_);
+        balancer_->init(loops_);
+    }
+
     // 整个服务端只有一个线程，运行baseloop
     if (numThreads_ == 0 && cb)
     {
@@ -53,6 +65,15 @@ EventLoop* EventLoopThreadPool::getNextLoop()
     return loop;
 }
 
+EventLoop* EventLoopThreadPool::getNextLoop(const InetAddress& peerAddr)
+{
+    if (!balancer_)
+    {
+        return baseLoop_;
+    }
+    return balancer_->select(peerAddr);
+}
+
 std::vector<EventLoop*> EventLoopThreadPool::getAllLoops()
 {
     if (loops_.empty())
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "noncopyable.h"
+#include "Poller.h"
+#include "LoadBalancer.h"
 
 #include <functional>
 #include <string>
@@ -9,6 +11,7 @@
 
 class EventLoop;
 class EventLoopThread;
+class InetAddress;
 
 class EventLoopThreadPool : noncopyable
 {
@@ -19,10 +22,18 @@ public:
     ~EventLoopThreadPool();
     
     void setThreadNum(int numThreads) { numThreads_ = numThreads; }
+    // subloop使用的IO复用实现，需要在start之前设置
+    void setPollerBackend(Poller::Backend backend) { backend_ = backend; }
+    // 第i个subloop绑定到cpus[i % cpus.size()]上，内存从该CPU所在的NUMA节点分配，需要在start之前设置
+    void setCpuAffinity(const std::vector<int>& cpus) { cpus_ = cpus; }
+    // 为新连接选择subloop的策略，需要在start之前设置
+    void setLoadBalancePolicy(LoadBalancer::Policy policy) { policy_ = policy; }
     void start(const ThreadInitCallback& cb = ThreadInitCallback());
 
     // 如果工作在多线程中，baseloop会默认以轮询的方式分配channel给subloop
     EventLoop* getNextLoop();
+    // 按setLoadBalancePolicy设置的策略为peerAddr的新连接选择loop
+    EventLoop* getNextLoop(const InetAddress& peerAddr);
 
     std::vector<EventLoop*> getAllLoops();
 
@@ -36,6 +47,10 @@ private:
     bool started_;
     int numThreads_;
     int next_;
+    Poller::Backend backend_;
+    LoadBalancer::Policy policy_;
+    std::vector<int> cpus_;
+    std::unique_ptr<LoadBalancer> balancer_;
     std::vector<std::unique_ptr<EventLoopThread>> threads_;
     std::vector<EventLoop*> loops_;
 };
\ No newline at end of file
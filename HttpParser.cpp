@@ -0,0 +1,278 @@
+#include "HttpParser.h"
+#include "Buffer.h"
+
+#include <algorithm>
+
+const size_t HttpParser::kDefaultMaxHeaderBytes;
+const size_t HttpParser::kDefaultMaxBodyBytes;
+
+namespace
+{
+
+HttpRequest::Slice makeSlice(const char* base, const char* begin, const char* end)
+{
+    return HttpRequest::Slice{ static_cast<uint32_t>(begin - base), static_cast<uint32_t>(end - begin) };
+}
+
+HttpRequest::Method toMethod(const StringPiece& name)
+{
+    static const struct { const char* name; HttpRequest::Method method; } methods[] = {
+        { "GET", HttpRequest::kGet },
+        { "POST", HttpRequest::kPost },
+        { "HEAD", HttpRequest::kHead },
+        { "PUT", HttpRequest::kPut },
+        { "DELETE", HttpRequest::kDelete },
+        { "OPTIONS", HttpRequest::kOptions },
+        { "PATCH", HttpRequest::kPatch },
+    };
+    for (const auto& m : methods)
+    {
+        if (name == m.name)
+        {
+            return m.method;
+        }
+    }
+    return HttpRequest::kInvalid;
+}
+
+bool isTokenChar(char c)
+{
+    return c > ' ' && c < 127 && c != ':';
+}
+
+// value中是否有逗号分隔的token（忽略大小写）
+bool containsToken(const StringPiece& value, const StringPiece& token)
+{
+    const char* p = value.begin();
+    while (p < value.end())
+    {
+        const char* comma = std::find(p, value.end(), ',');
+        const char* b = p;
+        const char* e = comma;
+        while (b < e && (*b == ' ' || *b == '\t')) ++b;
+        while (e > b && (e[-1] == ' ' || e[-1] == '\t')) --e;
+        if (StringPiece(b, e - b).caseEqual(token))
+        {
+            return true;
+        }
+        p = comma == value.end() ? comma : comma + 1;
+    }
+    return false;
+}
+
+} // namespace
+
+HttpParser::HttpParser()
+    : maxHeaderBytes_(kDefaultMaxHeaderBytes)
+    , maxBodyBytes_(kDefaultMaxBodyBytes)
+{
+    reset();
+}
+
+void HttpParser::reset()
+{
+    state_ = kRequestLine;
+    lineStart_ = 0;
+    searched_ = 0;
+    headerLength_ = 0;
+    errorCode_ = 0;
+    hasContentLength_ = false;
+    request_.reset();
+}
+
+HttpParser::Result HttpParser::fail(int code)
+{
+    errorCode_ = code;
+    return kError;
+}
+
+HttpParser::Result HttpParser::parse(const Buffer* buf)
+{
+    if (errorCode_)
+    {
+        return kError;
+    }
+    const size_t readable = buf->readableBytes();
+    if (readable == 0)
+    {
+        return kNeedMore; // 使用内存池的Buffer读完之后没有内存
+    }
+    const char* base = buf->peek();
+    while (state_ == kRequestLine || state_ == kHeaders)
+    {
+        const char* crlf = buf->findCRLF(base + searched_);
+        if (crlf == nullptr)
+        {
+            if (readable > maxHeaderBytes_)
+            {
+                return fail(431);
+            }
+            // 最后一个字节可能是\r，下次从它开始找
+            searched_ = std::max(lineStart_, readable > 0 ? readable - 1 : 0);
+            return kNeedMore;
+        }
+
+        const char* begin = base + lineStart_;
+        if (state_ == kRequestLine)
+        {
+            // 请求之前多余的空行忽略
+            if (begin != crlf)
+            {
+                if (!parseRequestLine(base, begin, crlf))
+                {
+                    return fail(errorCode_ ? errorCode_ : 400);
+                }
+                state_ = kHeaders;
+            }
+        }
+        else if (begin == crlf)
+        {
+            // 空行，头部结束
+            headerLength_ = crlf + 2 - base;
+            if (request_.chunked_)
+            {
+                return fail(501);
+            }
+            if (request_.contentLength_ > maxBodyBytes_)
+            {
+                return fail(413);
+            }
+            request_.body_ = HttpRequest::Slice{ static_cast<uint32_t>(headerLength_),
+                                                 static_cast<uint32_t>(request_.contentLength_) };
+            state_ = kBody;
+        }
+        else if (!parseHeader(base, begin, crlf))
+        {
+            return fail(400);
+        }
+
+        lineStart_ = searched_ = crlf + 2 - base;
+        if (state_ != kBody && lineStart_ > maxHeaderBytes_)
+        {
+            return fail(431);
+        }
+    }
+
+    if (state_ == kBody)
+    {
+        if (readable < headerLength_ + request_.contentLength_)
+        {
+            return kNeedMore;
+        }
+        state_ = kDone;
+    }
+    request_.base_ = base;
+    return kComplete;
+}
+
+// METHOD SP request-target SP HTTP-version
+bool HttpParser::parseRequestLine(const char* base, const char* begin, const char* end)
+{
+    const char* space = std::find(begin, end, ' ');
+    if (space == end || space == begin)
+    {
+        return false;
+    }
+    request_.methodName_ = makeSlice(base, begin, space);
+    request_.method_ = toMethod(StringPiece(begin, space - begin));
+
+    const char* target = space + 1;
+    space = std::find(target, end, ' ');
+    if (space == end || space == target)
+    {
+        return false;
+    }
+    const char* question = std::find(target, space, '?');
+    request_.path_ = makeSlice(base, target, question);
+    if (question != space)
+    {
+        request_.query_ = makeSlice(base, question + 1, space);
+    }
+
+    StringPiece version(space + 1, end - space - 1);
+    if (version == "HTTP/1.1")
+    {
+        request_.version_ = HttpRequest::kHttp11;
+        request_.keepAlive_ = true;
+    }
+    else if (version == "HTTP/1.0")
+    {
+        request_.version_ = HttpRequest::kHttp10;
+        request_.keepAlive_ = false;
+    }
+    else
+    {
+        errorCode_ = version.size() == 8 && ::memcmp(version.data(), "HTTP/", 5) == 0 ? 505 : 400;
+        return false;
+    }
+    return true;
+}
+
+// field-name ":" OWS field-value OWS
+bool HttpParser::parseHeader(const char* base, const char* begin, const char* end)
+{
+    const char* colon = std::find(begin, end, ':');
+    if (colon == end || colon == begin)
+    {
+        return false;
+    }
+    for (const char* p = begin; p < colon; ++p)
+    {
+        if (!isTokenChar(*p))
+        {
+            return false;
+        }
+    }
+    const char* value = colon + 1;
+    while (value < end && (*value == ' ' || *value == '\t')) ++value;
+    const char* valueEnd = end;
+    while (valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')) --valueEnd;
+
+    request_.headers_.push_back(HttpRequest::Header{ makeSlice(base, begin, colon), makeSlice(base, value, valueEnd) });
+
+    // 影响解析和连接管理的头部在这里直接处理
+    StringPiece name(begin, colon - begin);
+    StringPiece v(value, valueEnd - value);
+    if (name.caseEqual("Content-Length"))
+    {
+        if (v.empty())
+        {
+            return false;
+        }
+        size_t length = 0;
+        for (char c : v)
+        {
+            if (c < '0' || c > '9')
+            {
+                return false;
+            }
+            // 超过上限之后不再累加，避免溢出，头部结束时返回413
+            if (length <= maxBodyBytes_)
+            {
+                length = length * 10 + (c - '0');
+            }
+        }
+        if (hasContentLength_ && length != request_.contentLength_)
+        {
+            return false;
+        }
+        hasContentLength_ = true;
+        request_.contentLength_ = length;
+    }
+    else if (name.caseEqual("Transfer-Encoding"))
+    {
+        request_.chunked_ = true;
+    }
+    else if (name.caseEqual("Connection"))
+    {
+        if (containsToken(v, "close"))
+        {
+            request_.keepAlive_ = false;
+        }
+        else if (containsToken(v, "keep-alive"))
+        {
+            request_.keepAlive_ = true;
+        }
+    }
+    return true;
+}
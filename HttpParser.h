@@ -0,0 +1,54 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "HttpRequest.h"
+
+class Buffer;
+
+/**
+ * 增量的HTTP/1.x请求解析器，直接在输入Buffer上解析，不拷贝数据
+ * 数据不完整时返回kNeedMore，下次从上次停下的位置继续，已经解析过的行不会重新扫描
+ * 请求体只支持Content-Length，chunked编码的请求体返回501
+ * 一个请求完整之后，处理完需要retrieve(requestLength())并reset()，再解析同一个Buffer中的下一个请求（pipeline）
+*/
+class HttpParser : noncopyable
+{
+public:
+    enum Result { kNeedMore, kComplete, kError };
+
+    static const size_t kDefaultMaxHeaderBytes = 64 * 1024;
+    static const size_t kDefaultMaxBodyBytes = 8 * 1024 * 1024;
+
+    HttpParser();
+
+    void setMaxHeaderBytes(size_t n) { maxHeaderBytes_ = n; }
+    void setMaxBodyBytes(size_t n) { maxBodyBytes_ = n; }
+
+    // 解析buf中从peek()开始的一个请求
+    Result parse(const Buffer* buf);
+    void reset();
+
+    // kComplete之后有效，直到Buffer被retrieve或者写入
+    const HttpRequest& request() const { return request_; }
+    // 请求行、头部和请求体一共的字节数
+    size_t requestLength() const { return headerLength_ + request_.contentLength_; }
+    // kError时应答的状态码
+    int errorCode() const { return errorCode_; }
+
+private:
+    enum State { kRequestLine, kHeaders, kBody, kDone };
+
+    bool parseRequestLine(const char* base, const char* begin, const char* end);
+    bool parseHeader(const char* base, const char* begin, const char* end);
+    Result fail(int code);
+
+    State state_;
+    size_t lineStart_; // 当前行相对peek()的偏移
+    size_t searched_; // 已经查找过\r\n的位置，数据不完整时下次从这里继续
+    size_t headerLength_;
+    int errorCode_;
+    size_t maxHeaderBytes_;
+    size_t maxBodyBytes_;
+    bool hasContentLength_;
+    HttpRequest request_;
+};
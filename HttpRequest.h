@@ -0,0 +1,93 @@
+#pragma once
+
+#include "StringPiece.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * 一个HTTP请求，由HttpParser在输入Buffer上原地解析得到
+ * 各个字段只保存相对请求起始位置的偏移和长度，不拷贝成std::string
+ * 访问字段需要请求所在的内存仍然有效：HttpServer只在回调期间提供请求，回调返回之后数据就被retrieve
+*/
+class HttpRequest
+{
+public:
+    enum Method { kInvalid, kGet, kPost, kHead, kPut, kDelete, kOptions, kPatch };
+    enum Version { kUnknown, kHttp10, kHttp11 };
+
+    // 请求中的一段：相对请求起始位置的偏移和长度
+    struct Slice
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    HttpRequest()
+        : base_(nullptr)
+    {
+        reset();
+    }
+
+    // 清空，保留headers_的容量，同一个连接上的下一个请求不需要重新申请内存
+    void reset()
+    {
+        base_ = nullptr;
+        method_ = kInvalid;
+        version_ = kUnknown;
+        methodName_ = path_ = query_ = body_ = Slice{ 0, 0 };
+        headers_.clear();
+        contentLength_ = 0;
+        keepAlive_ = false;
+        chunked_ = false;
+    }
+
+    Method method() const { return method_; }
+    Version version() const { return version_; }
+    StringPiece methodName() const { return piece(methodName_); }
+    StringPiece path() const { return piece(path_); }
+    // ?之后的部分，不包括?
+    StringPiece query() const { return piece(query_); }
+    StringPiece body() const { return piece(body_); }
+    // 按HTTP版本和Connection头部确定的连接是否保持
+    bool keepAlive() const { return keepAlive_; }
+
+    size_t headerCount() const { return headers_.size(); }
+    StringPiece headerName(size_t i) const { return piece(headers_[i].name); }
+    StringPiece headerValue(size_t i) const { return piece(headers_[i].value); }
+    // 忽略大小写查找头部，没有时返回空
+    StringPiece getHeader(const StringPiece& name) const
+    {
+        for (const Header& h : headers_)
+        {
+            if (piece(h.name).caseEqual(name))
+            {
+                return piece(h.value);
+            }
+        }
+        return StringPiece();
+    }
+
+private:
+    friend class HttpParser;
+
+    struct Header
+    {
+        Slice name;
+        Slice value;
+    };
+
+    StringPiece piece(const Slice& s) const { return StringPiece(base_ + s.offset, s.length); }
+
+    const char* base_; // 请求的起始位置，由HttpParser在请求完整时设置
+    Method method_;
+    Version version_;
+    Slice methodName_;
+    Slice path_;
+    Slice query_;
+    Slice body_;
+    std::vector<Header> headers_;
+    size_t contentLength_;
+    bool keepAlive_;
+    bool chunked_; // 请求体使用chunked编码，暂不支持
+};
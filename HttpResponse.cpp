@@ -0,0 +1,157 @@
+#include "HttpResponse.h"
+#include "Buffer.h"
+#include "TcpConnection.h"
+
+#include <stdio.h>
+
+const size_t HttpResponse::kFlushBytes;
+
+namespace
+{
+
+void appendPiece(Buffer* output, const StringPiece& s)
+{
+    output->append(s.data(), s.size());
+}
+
+} // namespace
+
+HttpResponse::HttpResponse()
+    : statusCode_(k200Ok)
+    , closeConnection_(false)
+    , chunked_(false)
+    , http10_(false)
+    , headRequest_(false)
+    , output_(nullptr)
+    , conn_(nullptr)
+{
+}
+
+const char* HttpResponse::statusMessage(int code)
+{
+    switch (code)
+    {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    case 505: return "HTTP Version Not Supported";
+    default: return "Unknown";
+    }
+}
+
+void HttpResponse::addHeader(const StringPiece& name, const StringPiece& value)
+{
+    headers_.append(name.data(), name.size());
+    headers_.append(": ", 2);
+    headers_.append(value.data(), value.size());
+    headers_.append("\r\n", 2);
+}
+
+void HttpResponse::begin(Buffer* output, const TcpConnectionPtr& conn, bool http10, bool headRequest, bool close)
+{
+    statusCode_ = k200Ok;
+    closeConnection_ = close;
+    chunked_ = false;
+    http10_ = http10;
+    headRequest_ = headRequest;
+    headers_.clear();
+    body_.clear();
+    output_ = output;
+    conn_ = &conn;
+}
+
+void HttpResponse::appendStatusAndHeaders(bool chunked)
+{
+    char buf[64];
+    int n = snprintf(buf, sizeof buf, "HTTP/1.1 %d ", statusCode_);
+    output_->append(buf, n);
+    appendPiece(output_, statusMessage(statusCode_));
+    appendPiece(output_, "\r\n");
+    appendPiece(output_, headers_);
+    if (chunked)
+    {
+        // HTTP/1.0不支持chunked，body直接写出，以关闭连接结束
+        if (!http10_)
+        {
+            appendPiece(output_, "Transfer-Encoding: chunked\r\n");
+        }
+    }
+    else
+    {
+        n = snprintf(buf, sizeof buf, "Content-Length: %zu\r\n", body_.size());
+        output_->append(buf, n);
+    }
+    if (closeConnection_)
+    {
+        appendPiece(output_, "Connection: close\r\n");
+    }
+    else if (http10_)
+    {
+        appendPiece(output_, "Connection: Keep-Alive\r\n");
+    }
+    appendPiece(output_, "\r\n");
+}
+
+void HttpResponse::writeChunk(const StringPiece& data)
+{
+    if (!chunked_)
+    {
+        chunked_ = true;
+        if (http10_)
+        {
+            closeConnection_ = true;
+        }
+        appendStatusAndHeaders(true);
+    }
+    if (headRequest_ || data.empty())
+    {
+        return; // 长度为0的块表示结束，由finish写出
+    }
+    if (http10_)
+    {
+        appendPiece(output_, data);
+    }
+    else
+    {
+        char buf[32];
+        int n = snprintf(buf, sizeof buf, "%zx\r\n", data.size());
+        output_->append(buf, n);
+        appendPiece(output_, data);
+        appendPiece(output_, "\r\n");
+    }
+    if (output_->readableBytes() >= kFlushBytes)
+    {
+        (*conn_)->send(output_);
+    }
+}
+
+void HttpResponse::finish()
+{
+    if (chunked_)
+    {
+        if (!http10_ && !headRequest_)
+        {
+            appendPiece(output_, "0\r\n\r\n");
+        }
+    }
+    else
+    {
+        appendStatusAndHeaders(false);
+        if (!headRequest_)
+        {
+            appendPiece(output_, body_);
+        }
+    }
+    output_ = nullptr;
+    conn_ = nullptr;
+}
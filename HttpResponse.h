@@ -0,0 +1,79 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callback.h"
+#include "StringPiece.h"
+
+#include <string>
+
+class Buffer;
+
+/**
+ * HttpServer回调中填写的应答，回调返回之后由HttpServer序列化到连接的输出中
+ * 一般的应答设置状态码、头部和body，自动加上Content-Length
+ * 分块应答调用writeChunk，第一次调用时写出状态行和头部，之后每一块直接写入输出，
+ * 不需要先拼出完整的body；积压超过kFlushBytes时立即交给连接发送
+ * 同一个连接上的应答对象在请求之间复用
+*/
+class HttpResponse : noncopyable
+{
+public:
+    enum StatusCode
+    {
+        k200Ok = 200,
+        k204NoContent = 204,
+        k301MovedPermanently = 301,
+        k302Found = 302,
+        k304NotModified = 304,
+        k400BadRequest = 400,
+        k404NotFound = 404,
+        k405MethodNotAllowed = 405,
+        k413PayloadTooLarge = 413,
+        k431RequestHeaderFieldsTooLarge = 431,
+        k500InternalServerError = 500,
+        k501NotImplemented = 501,
+        k503ServiceUnavailable = 503,
+        k505VersionNotSupported = 505,
+    };
+
+    static const size_t kFlushBytes = 64 * 1024;
+
+    HttpResponse();
+
+    void setStatusCode(int code) { statusCode_ = code; }
+    int statusCode() const { return statusCode_; }
+    void setContentType(const StringPiece& contentType) { addHeader("Content-Type", contentType); }
+    // Content-Length、Transfer-Encoding和Connection由HttpResponse生成，不要自己添加
+    void addHeader(const StringPiece& name, const StringPiece& value);
+    void setBody(std::string body) { body_ = std::move(body); }
+    void appendBody(const StringPiece& data) { body_.append(data.data(), data.size()); }
+
+    void setCloseConnection(bool on) { closeConnection_ = on; }
+    bool closeConnection() const { return closeConnection_; }
+
+    // 分块发送body，调用之后setBody和addHeader不再生效
+    void writeChunk(const StringPiece& data);
+    bool chunked() const { return chunked_; }
+
+    // 状态码对应的原因短语
+    static const char* statusMessage(int code);
+
+private:
+    friend class HttpServer;
+
+    // 开始一个新的应答，output是连接的输出，conn用于积压较多时提前发送
+    void begin(Buffer* output, const TcpConnectionPtr& conn, bool http10, bool headRequest, bool close);
+    // 写出完整的应答，或者分块应答的结束块
+    void finish();
+    void appendStatusAndHeaders(bool chunked);
+
+    int statusCode_;
+    bool closeConnection_;
+    bool chunked_;
+    bool http10_;
+    bool headRequest_; // HEAD请求只写出头部
+    std::string headers_; // 已经格式化的"Name: value\r\n"
+    std::string body_;
+    Buffer* output_;
+    const TcpConnectionPtr* conn_;
+};
@@ -0,0 +1,104 @@
+#include "HttpServer.h"
+#include "HttpParser.h"
+#include "Logger.h"
+
+using namespace std::placeholders;
+
+struct HttpServer::Context
+{
+    explicit Context(EventLoop* loop)
+        : output(loop->bufferPool())
+        , closing(false)
+    {
+    }
+
+    HttpParser parser;
+    HttpResponse response;
+    Buffer output; // 一批pipeline请求的应答，处理完一起发送；发送之后内存还给loop的内存池
+    bool closing; // 已经决定关闭连接，之后收到的数据丢弃
+};
+
+static void defaultHttpCallback(const HttpRequest&, HttpResponse* resp)
+{
+    resp->setStatusCode(HttpResponse::k404NotFound);
+    resp->setCloseConnection(true);
+}
+
+HttpServer::HttpServer(EventLoop* loop,
+                       const InetAddress& listenAddr,
+                       const std::string& name,
+                       TcpServer::Option option)
+    : server_(loop, listenAddr, name, option)
+    , httpCallback_(defaultHttpCallback)
+    , maxHeaderBytes_(HttpParser::kDefaultMaxHeaderBytes)
+    , maxBodyBytes_(HttpParser::kDefaultMaxBodyBytes)
+{
+    server_.setConnectionCallback(std::bind(&HttpServer::onConnection, this, _1));
+}
+
+void HttpServer::start()
+{
+    LOG_INFO("HttpServer[%s] starts listening \n", server_.name().c_str());
+    server_.start();
+}
+
+void HttpServer::onConnection(const TcpConnectionPtr& conn)
+{
+    if (conn->connected())
+    {
+        std::shared_ptr<Context> context = std::make_shared<Context>(conn->getLoop());
+        context->parser.setMaxHeaderBytes(maxHeaderBytes_);
+        context->parser.setMaxBodyBytes(maxBodyBytes_);
+        conn->setMessageCallback(std::bind(&HttpServer::onMessage, this, _1, _2, _3, context));
+    }
+}
+
+void HttpServer::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp,
+                           const std::shared_ptr<Context>& context)
+{
+    Context* ctx = context.get();
+    if (ctx->closing)
+    {
+        buf->retrieveAll();
+        return;
+    }
+
+    HttpParser& parser = ctx->parser;
+    HttpResponse& response = ctx->response;
+    while (!ctx->closing)
+    {
+        HttpParser::Result result = parser.parse(buf);
+        if (result == HttpParser::kNeedMore)
+        {
+            break;
+        }
+        if (result == HttpParser::kError)
+        {
+            response.begin(&ctx->output, conn, false, false, true);
+            response.setStatusCode(parser.errorCode());
+            response.finish();
+            buf->retrieveAll();
+            ctx->closing = true;
+            break;
+        }
+
+        const HttpRequest& request = parser.request();
+        response.begin(&ctx->output, conn, request.version() == HttpRequest::kHttp10,
+                       request.method() == HttpRequest::kHead, !request.keepAlive());
+        httpCallback_(request, &response);
+        response.finish();
+        ctx->closing = response.closeConnection();
+
+        buf->retrieve(parser.requestLength());
+        parser.reset();
+    }
+
+    if (ctx->output.readableBytes() > 0)
+    {
+        conn->send(&ctx->output);
+    }
+    if (ctx->closing)
+    {
+        conn->shutdown(); // 输出发送完之后关闭写端
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "TcpServer.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+
+/**
+ * 基于TcpServer的HTTP/1.1服务器
+ * 请求在连接的输入Buffer上原地解析，回调中拿到的HttpRequest只在回调期间有效
+ * 支持keep-alive和pipeline：一次可读事件中收到的多个请求依次处理，应答按请求的顺序
+ * 写入同一个输出Buffer，处理完之后一次发送
+ * 回调在连接所在的loop线程中同步执行，需要在回调中填好应答
+*/
+class HttpServer : noncopyable
+{
+public:
+    using HttpCallback = std::function<void(const HttpRequest&, HttpResponse*)>;
+
+    HttpServer(EventLoop* loop,
+               const InetAddress& listenAddr,
+               const std::string& name,
+               TcpServer::Option option = TcpServer::kNoReusePort);
+
+    // 线程数、负载均衡等设置通过底层的TcpServer完成
+    TcpServer* server() { return &server_; }
+    void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
+
+    // 默认对所有请求应答404
+    void setHttpCallback(const HttpCallback& cb) { httpCallback_ = cb; }
+    // 请求行加头部的最大字节数，超过时应答431并关闭连接
+    void setMaxHeaderBytes(size_t n) { maxHeaderBytes_ = n; }
+    // 请求体的最大字节数，超过时应答413并关闭连接
+    void setMaxBodyBytes(size_t n) { maxBodyBytes_ = n; }
+
+    void start();
+
+private:
+    // 每个连接的解析状态和应答，只在连接所在的loop线程中访问
+    struct Context;
+
+    void onConnection(const TcpConnectionPtr& conn);
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime,
+                   const std::shared_ptr<Context>& context);
+
+    TcpServer server_;
+    HttpCallback httpCallback_;
+    size_t maxHeaderBytes_;
+    size_t maxBodyBytes_;
+};
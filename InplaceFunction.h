@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// InplaceFunction默认的内联存储大小，足够放下 std::bind(成员函数指针, shared_ptr, std::string)
+#ifndef MYMUDUO_INPLACE_FUNCTION_SIZE
+#define MYMUDUO_INPLACE_FUNCTION_SIZE 64
+#endif
+
+template <typename Signature, size_t InlineSize = MYMUDUO_INPLACE_FUNCTION_SIZE>
+class InplaceFunction;
+
+/**
+ * 只能移动的可调用对象，用来替代std::function保存EventLoop的Functor和Channel的回调
+ * 可调用对象不超过InlineSize字节时直接构造在对象内部的缓冲区中，不会申请堆内存
+ * （libstdc++的std::function只能内联16字节，bind一个成员函数指针加shared_ptr就要申请内存）
+ * 超过InlineSize或者移动构造可能抛异常的可调用对象退化为保存在堆上
+*/
+template <typename R, typename... Args, size_t InlineSize>
+class InplaceFunction<R(Args...), InlineSize>
+{
+public:
+    InplaceFunction() noexcept : ops_(nullptr) {}
+    InplaceFunction(std::nullptr_t) noexcept : ops_(nullptr) {}
+
+    template <typename F,
+              typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<F>::type, InplaceFunction>::value>::type>
+    InplaceFunction(F&& f)
+        : ops_(nullptr)
+    {
+        using Functor = typename std::decay<F>::type;
+        if (isNull(f))
+        {
+            return; // 和std::function一样，空的std::function、空函数指针构造出来的也是空的
+        }
+        init<Functor>(std::forward<F>(f), std::integral_constant<bool, fitsInline<Functor>()>());
+    }
+
+    InplaceFunction(InplaceFunction&& other) noexcept
+        : ops_(other.ops_)
+    {
+        if (ops_)
+        {
+            ops_->move(&storage_, &other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            if (other.ops_)
+            {
+                other.ops_->move(&storage_, &other.storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    InplaceFunction& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    ~InplaceFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+    // 和std::function一样，operator()是const的，但可以调用非const的可调用对象
+    R operator()(Args... args) const
+    {
+        return ops_->invoke(const_cast<Storage*>(&storage_), std::forward<Args>(args)...);
+    }
+
+private:
+    using Storage = typename std::aligned_storage<InlineSize, alignof(std::max_align_t)>::type;
+
+    // 每种可调用对象类型对应一张静态的函数表
+    struct Ops
+    {
+        R (*invoke)(void* storage, Args&&... args);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void* storage);
+    };
+
+    // 能和nullptr比较的可调用对象，为空时不保存
+    template <typename F>
+    static bool isNull(const F&) { return false; }
+    template <typename Sig>
+    static bool isNull(const std::function<Sig>& f) { return !f; }
+    template <typename Sig, size_t N>
+    static bool isNull(const InplaceFunction<Sig, N>& f) { return !f; }
+    template <typename Ret, typename... A>
+    static bool isNull(Ret (* const& f)(A...)) { return f == nullptr; }
+
+    template <typename F>
+    static constexpr bool fitsInline()
+    {
+        return sizeof(F) <= sizeof(Storage)
+            && alignof(F) <= alignof(Storage)
+            && std::is_nothrow_move_constructible<F>::value;
+    }
+
+    // 可调用对象直接保存在storage_中
+    template <typename F>
+    struct InlineOps
+    {
+        static R invoke(void* storage, Args&&... args)
+        {
+            return static_cast<R>((*static_cast<F*>(storage))(std::forward<Args>(args)...));
+        }
+        static void move(void* dst, void* src)
+        {
+            F* from = static_cast<F*>(src);
+            ::new (dst) F(std::move(*from));
+            from->~F();
+        }
+        static void destroy(void* storage)
+        {
+            static_cast<F*>(storage)->~F();
+        }
+        static const Ops* get()
+        {
+            static const Ops ops = { &invoke, &move, &destroy };
+            return &ops;
+        }
+    };
+
+    // 可调用对象保存在堆上，storage_中只保存指针
+    template <typename F>
+    struct HeapOps
+    {
+        static R invoke(void* storage, Args&&... args)
+        {
+            return static_cast<R>((**static_cast<F**>(storage))(std::forward<Args>(args)...));
+        }
+        static void move(void* dst, void* src)
+        {
+            *static_cast<F**>(dst) = *static_cast<F**>(src);
+        }
+        static void destroy(void* storage)
+        {
+            delete *static_cast<F**>(storage);
+        }
+        static const Ops* get()
+        {
+            static const Ops ops = { &invoke, &move, &destroy };
+            return &ops;
+        }
+    };
+
+    template <typename F, typename Arg>
+    void init(Arg&& f, std::true_type)
+    {
+        ::new (&storage_) F(std::forward<Arg>(f));
+        ops_ = InlineOps<F>::get();
+    }
+
+    template <typename F, typename Arg>
+    void init(Arg&& f, std::false_type)
+    {
+        *reinterpret_cast<F**>(&storage_) = new F(std::forward<Arg>(f));
+        ops_ = HeapOps<F>::get();
+    }
+
+    void reset() noexcept
+    {
+        if (ops_)
+        {
+            ops_->destroy(&storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    Storage storage_;
+    const Ops* ops_;
+};
@@ -0,0 +1,472 @@
+#include "IoUringPoller.h"
+#include "Logger.h"
+#include "Channel.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+const int kNew = -1;
+const int kAdded = 1;
+
+// POLL_REMOVE等内部请求的user_data，完成事件直接丢弃；POLL_ADD的编号从1开始
+const uint64_t kInternalUserData = 0;
+
+// IORING_FEAT_RSRC_TAGS和multishot poll同在5.13加入，没有单独的特性位，用它来判断
+const uint32_t IoUringPoller::kAcceptTag;
+
+const unsigned kRequiredFeatures = IORING_FEAT_SINGLE_MMAP
+                                 | IORING_FEAT_NODROP
+                                 | IORING_FEAT_EXT_ARG
+                                 | IORING_FEAT_RSRC_TAGS;
+
+static int ioUringSetup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                        unsigned flags, const void* arg, size_t argSize)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize));
+}
+
+bool IoUringPoller::isSupported()
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof params);
+    int fd = ioUringSetup(2, &params);
+    if (fd < 0)
+    {
+        return false;
+    }
+    ::close(fd);
+    return (params.features & kRequiredFeatures) == kRequiredFeatures;
+}
+
+IoUringPoller::IoUringPoller(EventLoop* loop)
+    : Poller(loop)
+    , ringfd_(-1)
+    , features_(0)
+    , ring_(MAP_FAILED)
+    , ringSize_(0)
+    , sqes_(nullptr)
+    , sqesSize_(0)
+    , sqLocalTail_(0)
+    , acceptSupported_(true)
+    , nextGeneration_(1)
+    , round_(0)
+{
+    // 只有loop线程提交和等待：内核的完成处理推迟到io_uring_enter等待时批量执行，
+    // 不会在每个multishot完成时打断loop线程（6.1以上，不支持时不带这些标志）
+    io_uring_params params;
+    memset(&params, 0, sizeof params);
+    params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    ringfd_ = ioUringSetup(kRingEntries, &params);
+    if (ringfd_ < 0 && errno == EINVAL)
+    {
+        memset(&params, 0, sizeof params);
+        ringfd_ = ioUringSetup(kRingEntries, &params);
+    }
+    if (ringfd_ < 0)
+    {
+        LOG_FATAL("io_uring_setup error:%d \n", errno);
+    }
+    features_ = params.features;
+
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    ringSize_ = sqSize > cqSize ? sqSize : cqSize;
+    ring_ = ::mmap(nullptr, ringSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ringfd_, IORING_OFF_SQ_RING);
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ringfd_, IORING_OFF_SQES);
+    if (ring_ == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        LOG_FATAL("io_uring mmap error:%d \n", errno);
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* base = static_cast<char*>(ring_);
+    sqHead_ = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    sqArray_ = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    sqMask_ = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    sqEntries_ = params.sq_entries;
+    sqLocalTail_ = *sqTail_;
+
+    cqHead_ = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+}
+
+IoUringPoller::~IoUringPoller()
+{
+    submitPending();
+    // 取消之前已经accept出来的连接
+    unsigned head = *cqHead_;
+    const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+        const io_uring_cqe& cqe = cqes_[head & cqMask_];
+        if ((static_cast<uint32_t>(cqe.user_data >> 32) & kAcceptTag) && cqe.res >= 0)
+        {
+            ::close(cqe.res);
+        }
+    }
+    while (!accepted_.empty())
+    {
+        closeAccepted(accepted_.begin()->first);
+    }
+    ::munmap(sqes_, sqesSize_);
+    ::munmap(ring_, ringSize_);
+    ::close(ringfd_);
+}
+
+Timestamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+    LOG_DEBUG("func=%s, fd total count:%zu\n", __FUNCTION__, channels_.size());
+    // 上一轮触发过的单次poll重新注册，和等待一起提交
+    for (int fd : rearm_)
+    {
+        auto it = states_.find(fd);
+        if (it != states_.end() && !it->second.armed && !it->second.channel->isNoneEvent())
+        {
+            armPoll(fd, &it->second);
+        }
+    }
+    rearm_.clear();
+
+    __kernel_timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = (timeoutMs % 1000) * 1000000LL;
+    io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof arg);
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = timeoutMs < 0 ? 0 : reinterpret_cast<uint64_t>(&ts);
+
+    unsigned toSubmit = flushSq();
+    int ret = ioUringEnter(ringfd_, toSubmit, 1,
+                           IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof arg);
+    int savedErrno = errno;
+    Timestamp now(Timestamp::now());
+
+    if (ret < 0 && savedErrno != ETIME && savedErrno != EINTR)
+    {
+        errno = savedErrno;
+        LOG_ERROR("IoUringPoller:poll()");
+    }
+    fillActiveChannels(activeChannels);
+    return now;
+}
+
+void IoUringPoller::updateChannel(Channel* channel)
+{
+    const int fd = channel->fd();
+    LOG_DEBUG("func-%s, fd=%d events=%d index=%d \n", __FUNCTION__, fd, channel->events(), channel->index());
+    PollState& state = addState(channel);
+    if (channel->isNoneEvent())
+    {
+        if (state.armed)
+        {
+            cancelPoll(fd, &state);
+        }
+        return;
+    }
+
+    // io_uring的poll本身就是边缘触发的，不需要EPOLLET
+    const int events = channel->events() & ~EPOLLET;
+    const bool multishot = channel->edgeTriggered();
+    if (state.armed && state.events == events && state.multishot == multishot)
+    {
+        return;
+    }
+    if (state.armed)
+    {
+        cancelPoll(fd, &state);
+    }
+    state.events = events;
+    state.multishot = multishot;
+    armPoll(fd, &state);
+}
+
+void IoUringPoller::removeChannel(Channel* channel)
+{
+    const int fd = channel->fd();
+    LOG_DEBUG("func-%s, fd=%d \n", __FUNCTION__, fd);
+    auto it = states_.find(fd);
+    bool accept = false;
+    if (it != states_.end())
+    {
+        // 提交队列是按顺序执行的，即使fd随后被关闭、复用，这里的POLL_REMOVE也会取消掉之前的POLL_ADD
+        if (it->second.armed)
+        {
+            cancelPoll(fd, &it->second);
+        }
+        accept = it->second.accept;
+        states_.erase(it);
+    }
+    closeAccepted(fd);
+    channels_.erase(fd);
+    channel->set_index(kNew);
+
+    if (accept)
+    {
+        // 马上提交取消，内核放掉ACCEPT请求对监听socket的引用，关闭之后可以立即重新bind这个端口
+        submitPending();
+    }
+}
+
+bool IoUringPoller::enableMultishotAccept(Channel* channel)
+{
+    if (!acceptSupported_)
+    {
+        return false;
+    }
+    const int fd = channel->fd();
+    PollState& state = addState(channel);
+    if (!state.accept)
+    {
+        if (state.armed)
+        {
+            cancelPoll(fd, &state);
+        }
+        state.accept = true;
+        if (!channel->isNoneEvent())
+        {
+            armPoll(fd, &state);
+        }
+    }
+    return true;
+}
+
+bool IoUringPoller::takeAccepted(Channel* channel, std::vector<int>* fds)
+{
+    const int fd = channel->fd();
+    auto it = states_.find(fd);
+    if (it == states_.end() || !it->second.accept)
+    {
+        return false;
+    }
+    auto acc = accepted_.find(fd);
+    if (acc != accepted_.end())
+    {
+        fds->insert(fds->end(), acc->second.begin(), acc->second.end());
+        acc->second.clear();
+    }
+    return true;
+}
+
+IoUringPoller::PollState& IoUringPoller::addState(Channel* channel)
+{
+    const int fd = channel->fd();
+    if (channel->index() == kNew)
+    {
+        channels_[fd] = channel;
+        PollState& state = states_[fd];
+        memset(&state, 0, sizeof state);
+        state.channel = channel;
+        channel->set_index(kAdded);
+        return state;
+    }
+    return states_[fd];
+}
+
+void IoUringPoller::closeAccepted(int fd)
+{
+    auto it = accepted_.find(fd);
+    if (it != accepted_.end())
+    {
+        for (int connfd : it->second)
+        {
+            if (connfd >= 0)
+            {
+                ::close(connfd);
+            }
+        }
+        accepted_.erase(it);
+    }
+}
+
+io_uring_sqe* IoUringPoller::getSqe()
+{
+    if (sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_)
+    {
+        // 提交队列满了，先提交一次，不等待
+        unsigned toSubmit = flushSq();
+        if (ioUringEnter(ringfd_, toSubmit, 0, 0, nullptr, 0) < 0)
+        {
+            LOG_FATAL("io_uring_enter submit error:%d \n", errno);
+        }
+    }
+    unsigned index = sqLocalTail_ & sqMask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof *sqe);
+    sqArray_[index] = index;
+    ++sqLocalTail_;
+    return sqe;
+}
+
+void IoUringPoller::submitPending()
+{
+    // GETEVENTS让推迟的完成处理（DEFER_TASKRUN）也执行掉，不等待
+    unsigned toSubmit = flushSq();
+    if (ioUringEnter(ringfd_, toSubmit, 0, IORING_ENTER_GETEVENTS, nullptr, 0) < 0)
+    {
+        LOG_ERROR("io_uring_enter submit error:%d \n", errno);
+    }
+}
+
+unsigned IoUringPoller::flushSq()
+{
+    __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+    return sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+}
+
+void IoUringPoller::armPoll(int fd, PollState* state)
+{
+    state->generation = nextGeneration_++;
+    if (nextGeneration_ == kAcceptTag)
+    {
+        nextGeneration_ = 1;
+    }
+    state->armed = true;
+
+    io_uring_sqe* sqe = getSqe();
+    if (state->accept)
+    {
+        // 不要对端地址：multishot的每次accept都会覆盖同一块地址，由调用方getpeername
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = fd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        sqe->user_data = userData(fd, state->generation | kAcceptTag);
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = static_cast<uint32_t>(state->events);
+    sqe->len = state->multishot ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = userData(fd, state->generation);
+}
+
+void IoUringPoller::cancelPoll(int fd, PollState* state)
+{
+    state->armed = false;
+
+    io_uring_sqe* sqe = getSqe();
+    if (state->accept)
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = userData(fd, state->generation | kAcceptTag);
+    }
+    else
+    {
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->addr = userData(fd, state->generation);
+    }
+    sqe->fd = -1;
+    sqe->user_data = kInternalUserData;
+    if (features_ & IORING_FEAT_CQE_SKIP)
+    {
+        sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+    }
+    // 被取消的请求可能在POLL_REMOVE执行之前就已经完成，编号清零丢弃它的完成事件
+    state->generation = 0;
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels)
+{
+    ++round_;
+    const size_t first = activeChannels->size();
+    unsigned head = *cqHead_;
+    const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+        const io_uring_cqe& cqe = cqes_[head & cqMask_];
+        if (cqe.user_data == kInternalUserData)
+        {
+            continue;
+        }
+        const int fd = static_cast<int>(static_cast<uint32_t>(cqe.user_data));
+        const uint32_t tagged = static_cast<uint32_t>(cqe.user_data >> 32);
+        const uint32_t generation = tagged & ~kAcceptTag;
+        auto it = states_.find(fd);
+        if (it == states_.end() || it->second.generation != generation)
+        {
+            // 已经取消或者重新注册过的旧请求；取消之前accept出来的连接没有人会取走
+            if ((tagged & kAcceptTag) && cqe.res >= 0)
+            {
+                ::close(cqe.res);
+            }
+            continue;
+        }
+
+        PollState& state = it->second;
+        int revents = cqe.res;
+        if (tagged & kAcceptTag)
+        {
+            if (!handleAcceptCompletion(fd, &state, cqe.res))
+            {
+                continue;
+            }
+            revents = EPOLLIN;
+        }
+        else if (cqe.res < 0)
+        {
+            state.armed = false;
+            if (cqe.res != -ECANCELED)
+            {
+                LOG_ERROR("IoUringPoller poll fd=%d error:%d \n", fd, -cqe.res);
+            }
+            continue;
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE))
+        {
+            // 单次poll已经触发，或者multishot被内核终止，下一轮重新注册
+            state.armed = false;
+            rearm_.push_back(fd);
+        }
+        if (state.round != round_)
+        {
+            state.round = round_;
+            state.revents = 0;
+            activeChannels->push_back(state.channel);
+        }
+        state.revents |= revents;
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+
+    for (size_t i = first; i < activeChannels->size(); ++i)
+    {
+        Channel* channel = (*activeChannels)[i];
+        channel->set_revents(states_[channel->fd()].revents);
+    }
+}
+
+bool IoUringPoller::handleAcceptCompletion(int fd, PollState* state, int res)
+{
+    if (res == -ECANCELED)
+    {
+        state->armed = false;
+        return false;
+    }
+    if (res == -EINVAL)
+    {
+        // 内核不支持multishot accept，退回POLL_ADD，下一轮重新注册之后由调用方自己accept
+        LOG_INFO("IoUringPoller multishot accept not supported, fall back to poll \n");
+        acceptSupported_ = false;
+        state->accept = false;
+        closeAccepted(fd);
+        return true;
+    }
+    accepted_[fd].push_back(res);
+    return true;
+}
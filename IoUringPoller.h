@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Poller.h"
+#include "Timestamp.h"
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include <linux/io_uring.h>
+
+class Channel;
+
+/**
+ * 基于io_uring的Poller，不依赖liburing，直接使用io_uring_setup/io_uring_enter
+ * 每个Channel对应一个IORING_OP_POLL_ADD请求：
+ *   边缘触发的Channel使用multishot poll，注册一次一直有效
+ *   水平触发的Channel使用单次poll，触发之后在下一次poll时重新注册，
+ *   注册时内核会立即检查一次就绪状态，所以没读完的数据会马上再次通知
+ * 注册、修改、删除都只是往提交队列里放请求，和等待完成事件一起由一次io_uring_enter提交，
+ * 每轮循环只有一次系统调用，不再有epoll_ctl
+ *
+ * 监听socket可以改用multishot accept（enableMultishotAccept）：内核accept好连接，
+ * 完成事件里直接是新连接的fd，不再需要可读之后逐个调用accept
+*/
+class IoUringPoller : public Poller
+{
+public:
+    IoUringPoller(EventLoop* loop);
+    ~IoUringPoller() override;
+
+    Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+
+    bool enableMultishotAccept(Channel* channel) override;
+    bool takeAccepted(Channel* channel, std::vector<int>* fds) override;
+
+    // 内核是否支持这里用到的特性（multishot poll、EXT_ARG等，5.13以上）
+    static bool isSupported();
+
+private:
+    static const unsigned kRingEntries = 1024;
+    // user_data中编号的最高位，标记ACCEPT请求，旧请求accept出来的fd需要关闭
+    static const uint32_t kAcceptTag = 1u << 31;
+
+    struct PollState
+    {
+        Channel* channel;
+        uint32_t generation; // 当前POLL_ADD请求的编号，旧请求的完成事件据此丢弃
+        int events; // 当前注册的事件
+        bool armed; // 请求已经在提交队列或者内核中
+        bool multishot;
+        bool accept; // 监听socket，用multishot accept代替POLL_ADD
+        int revents; // 本轮合并的事件
+        uint64_t round; // 最近一次加入activeChannels的轮次
+    };
+
+    static uint64_t userData(int fd, uint32_t generation)
+    {
+        return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+    }
+
+    io_uring_sqe* getSqe();
+    // 把本地的队尾写回共享内存，返回还没有提交的请求个数
+    unsigned flushSq();
+    // 立即提交队列中的请求
+    void submitPending();
+    PollState& addState(Channel* channel);
+    void armPoll(int fd, PollState* state);
+    void cancelPoll(int fd, PollState* state);
+    // 返回是否需要通知channel
+    bool handleAcceptCompletion(int fd, PollState* state, int res);
+    void closeAccepted(int fd);
+    void fillActiveChannels(ChannelList* activeChannels);
+
+    int ringfd_;
+    unsigned features_;
+
+    void* ring_; // SQ和CQ共用一次mmap（IORING_FEAT_SINGLE_MMAP）
+    size_t ringSize_;
+    io_uring_sqe* sqes_;
+    size_t sqesSize_;
+
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned* sqArray_;
+    unsigned sqMask_;
+    unsigned sqEntries_;
+    unsigned sqLocalTail_;
+
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+
+    std::unordered_map<int, PollState> states_;
+    std::vector<int> rearm_; // 单次poll已经触发，需要重新注册的fd
+    std::unordered_map<int, std::vector<int>> accepted_; // 监听fd -> 已经accept、还没有取走的fd
+    bool acceptSupported_; // 内核支持multishot accept（5.19以上），第一次提交返回EINVAL时置为false
+    uint32_t nextGeneration_;
+    uint64_t round_;
+};
@@ -0,0 +1,92 @@
+#include "LengthHeaderCodec.h"
+#include "Buffer.h"
+#include "Logger.h"
+#include "TcpConnection.h"
+
+const size_t LengthHeaderCodec::kDefaultMaxFrameBytes;
+
+LengthHeaderCodec::LengthHeaderCodec(const FrameCallback& cb, size_t headerBytes, size_t maxFrameBytes)
+    : frameCallback_(cb)
+    , headerBytes_(headerBytes)
+    , maxFrameBytes_(maxFrameBytes)
+{
+    if (headerBytes != 2 && headerBytes != 4 && headerBytes != 8)
+    {
+        LOG_FATAL("%s:%s:%d LengthHeaderCodec header must be 2, 4 or 8 bytes, got %zu \n",
+            __FILE__, __FUNCTION__, __LINE__, headerBytes);
+    }
+}
+
+size_t LengthHeaderCodec::peekLength(const Buffer* buf) const
+{
+    switch (headerBytes_)
+    {
+    case 2: return static_cast<uint16_t>(buf->peekInt16());
+    case 4: return static_cast<uint32_t>(buf->peekInt32());
+    default: return static_cast<uint64_t>(buf->peekInt64());
+    }
+}
+
+void LengthHeaderCodec::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime)
+{
+    while (buf->readableBytes() >= headerBytes_)
+    {
+        size_t length = peekLength(buf);
+        if (length > maxFrameBytes_)
+        {
+            LOG_ERROR("LengthHeaderCodec - %s invalid frame length %zu \n", conn->name().c_str(), length);
+            buf->retrieveAll();
+            conn->forceClose();
+            break;
+        }
+        if (buf->readableBytes() - headerBytes_ < length)
+        {
+            break; // 帧还不完整
+        }
+        frameCallback_(conn, StringPiece(buf->peek() + headerBytes_, length), receiveTime);
+        buf->retrieve(headerBytes_ + length);
+    }
+}
+
+bool LengthHeaderCodec::encode(Buffer* buf) const
+{
+    size_t length = buf->readableBytes();
+    if (length > maxFrameBytes_ || (headerBytes_ == 2 && length > 0xffff))
+    {
+        LOG_ERROR("LengthHeaderCodec - frame of %zu bytes is too large \n", length);
+        return false;
+    }
+    if (buf->prependableBytes() < headerBytes_)
+    {
+        // 前面没有空间（调用者自己retrieve过），只能整体拷贝一次
+        Buffer framed(headerBytes_ + length);
+        framed.append(buf->peek(), length);
+        buf->swap(framed);
+    }
+    switch (headerBytes_)
+    {
+    case 2: buf->prependInt16(static_cast<int16_t>(length)); break;
+    case 4: buf->prependInt32(static_cast<int32_t>(length)); break;
+    default: buf->prependInt64(static_cast<int64_t>(length)); break;
+    }
+    return true;
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr& conn, Buffer* buf) const
+{
+    if (encode(buf))
+    {
+        conn->send(buf);
+    }
+    else
+    {
+        buf->retrieveAll();
+    }
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr& conn, const StringPiece& frame) const
+{
+    Buffer buf(frame.size());
+    buf.append(frame.data(), frame.size());
+    send(conn, &buf);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callback.h"
+#include "StringPiece.h"
+#include "Timestamp.h"
+
+#include <functional>
+
+class Buffer;
+
+/**
+ * 长度前缀的分帧：每帧是网络字节序的长度头（2、4或8字节，不包括头本身）加上内容
+ * 收：把onMessage设为连接的messageCallback，输入Buffer中每个完整的帧以StringPiece交给frameCallback，
+ *     不拷贝，帧只在回调期间有效；超过maxFrameBytes的帧视为协议错误，关闭连接
+ * 发：内容先写入一个Buffer，send时在前面原地写入长度头，连同内容一起交给连接发送，不再拼接std::string
+ * 没有状态，可以在多个连接、多个loop之间共用
+*/
+class LengthHeaderCodec : noncopyable
+{
+public:
+    using FrameCallback = std::function<void(const TcpConnectionPtr&, const StringPiece&, Timestamp)>;
+
+    static const size_t kDefaultMaxFrameBytes = 64 * 1024 * 1024;
+
+    explicit LengthHeaderCodec(const FrameCallback& cb,
+                               size_t headerBytes = 4,
+                               size_t maxFrameBytes = kDefaultMaxFrameBytes);
+
+    size_t headerBytes() const { return headerBytes_; }
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime);
+
+    // buf的可读数据是一帧的内容，发送之后buf被清空；帧过大时不发送
+    void send(const TcpConnectionPtr& conn, Buffer* buf) const;
+    // 内容拷贝一次到Buffer中再发送
+    void send(const TcpConnectionPtr& conn, const StringPiece& frame) const;
+
+    // 在buf的可读数据前写入长度头，buf中就是完整的一帧；超过maxFrameBytes或者长度头放不下时返回false
+    bool encode(Buffer* buf) const;
+
+private:
+    size_t peekLength(const Buffer* buf) const;
+
+    FrameCallback frameCallback_;
+    const size_t headerBytes_;
+    const size_t maxFrameBytes_;
+};
@@ -0,0 +1,138 @@
+#include "LoadBalancer.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+
+#include <algorithm>
+#include <stdint.h>
+#include <utility>
+
+namespace
+{
+
+class RoundRobinBalancer : public LoadBalancer
+{
+public:
+    RoundRobinBalancer() : next_(0) {}
+
+    EventLoop* select(const InetAddress&) override
+    {
+        EventLoop* loop = loops_[next_];
+        next_ = (next_ + 1) % loops_.size();
+        return loop;
+    }
+
+private:
+    size_t next_;
+};
+
+// 负载最小的loop，负载相同时从上一次选中的下一个开始，避免总是选中第一个
+template <typename Less>
+class LeastLoadBalancer : public LoadBalancer
+{
+public:
+    LeastLoadBalancer() : next_(0) {}
+
+    EventLoop* select(const InetAddress&) override
+    {
+        const size_t n = loops_.size();
+        size_t best = next_;
+        for (size_t i = 1; i < n; ++i)
+        {
+            size_t index = (next_ + i) % n;
+            if (less_(loops_[index], loops_[best]))
+            {
+                best = index;
+            }
+        }
+        next_ = (best + 1) % n;
+        return loops_[best];
+    }
+
+private:
+    Less less_;
+    size_t next_;
+};
+
+struct FewerConnections
+{
+    bool operator()(const EventLoop* a, const EventLoop* b) const
+    {
+        return a->numConnections() < b->numConnections();
+    }
+};
+
+struct FewerPendingBytes
+{
+    bool operator()(const EventLoop* a, const EventLoop* b) const
+    {
+        int64_t pa = a->pendingBytes();
+        int64_t pb = b->pendingBytes();
+        return pa != pb ? pa < pb : a->numConnections() < b->numConnections();
+    }
+};
+
+// murmur3的finalizer，把相邻的整数打散到整个32位空间
+inline uint32_t mix(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+// 哈希环，每个loop放kVirtualNodes个虚拟节点，使各loop分到的区间大致均匀
+class ConsistentHashBalancer : public LoadBalancer
+{
+public:
+    static const int kVirtualNodes = 160;
+
+    void init(const std::vector<EventLoop*>& loops) override
+    {
+        LoadBalancer::init(loops);
+        ring_.clear();
+        for (size_t i = 0; i < loops.size(); ++i)
+        {
+            for (int v = 0; v < kVirtualNodes; ++v)
+            {
+                uint32_t h = mix(static_cast<uint32_t>(i) * 0x9e3779b9u + mix(static_cast<uint32_t>(v)));
+                ring_.push_back(std::make_pair(h, i));
+            }
+        }
+        std::sort(ring_.begin(), ring_.end());
+    }
+
+    EventLoop* select(const InetAddress& peerAddr) override
+    {
+        // 只按ip哈希，同一个客户端的多个连接落在同一个loop
+        uint32_t h = mix(peerAddr.getSockAddr()->sin_addr.s_addr);
+        auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(h, static_cast<size_t>(0)));
+        if (it == ring_.end())
+        {
+            it = ring_.begin();
+        }
+        return loops_[it->second];
+    }
+
+private:
+    std::vector<std::pair<uint32_t, size_t>> ring_;
+};
+
+} // namespace
+
+std::unique_ptr<LoadBalancer> LoadBalancer::newBalancer(Policy policy)
+{
+    switch (policy)
+    {
+    case kLeastConnections:
+        return std::unique_ptr<LoadBalancer>(new LeastLoadBalancer<FewerConnections>);
+    case kLeastPendingBytes:
+        return std::unique_ptr<LoadBalancer>(new LeastLoadBalancer<FewerPendingBytes>);
+    case kConsistentHash:
+        return std::unique_ptr<LoadBalancer>(new ConsistentHashBalancer);
+    case kRoundRobin:
+    default:
+        return std::unique_ptr<LoadBalancer>(new RoundRobinBalancer);
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <memory>
+#include <vector>
+
+class EventLoop;
+class InetAddress;
+
+/**
+ * EventLoopThreadPool为新连接选择subloop的策略，只在baseloop线程中调用
+ * 连接数、待发送字节数来自EventLoop的负载统计
+*/
+class LoadBalancer : noncopyable
+{
+public:
+    enum Policy
+    {
+        kRoundRobin, // 轮询
+        kLeastConnections, // 当前连接数最少的loop
+        kLeastPendingBytes, // 输出缓冲区中待发送字节数最少的loop，相同时比较连接数
+        kConsistentHash, // 按对端ip做一致性哈希，同一个客户端总是分到同一个loop
+    };
+
+    virtual ~LoadBalancer() = default;
+
+    // 线程池启动之后调用一次，loops之后不再变化
+    virtual void init(const std::vector<EventLoop*>& loops) { loops_ = loops; }
+    virtual EventLoop* select(const InetAddress& peerAddr) = 0;
+
+    static std::unique_ptr<LoadBalancer> newBalancer(Policy policy);
+
+protected:
+    std::vector<EventLoop*> loops_;
+};
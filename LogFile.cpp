@@ -0,0 +1,109 @@
+#include "LogFile.h"
+
+#include <unistd.h>
+#include <string.h>
+
+LogFile::LogFile(const std::string& basename, off_t rollSize)
+    : basename_(basename)
+    , rollSize_(rollSize)
+    , fp_(nullptr)
+    , writtenBytes_(0)
+    , startOfPeriod_(0)
+    , lastRoll_(0)
+{
+    rollFile();
+}
+
+LogFile::~LogFile()
+{
+    if (fp_)
+    {
+        ::fclose(fp_);
+    }
+}
+
+void LogFile::append(const char* logline, size_t len)
+{
+    if (fp_ == nullptr)
+    {
+        return;
+    }
+    size_t written = 0;
+    while (written != len)
+    {
+        size_t n = ::fwrite_unlocked(logline + written, 1, len - written, fp_);
+        if (n == 0)
+        {
+            fprintf(stderr, "LogFile::append() failed %s\n", strerror(ferror(fp_)));
+            break;
+        }
+        written += n;
+    }
+    writtenBytes_ += written;
+
+    if (writtenBytes_ > rollSize_)
+    {
+        rollFile();
+    }
+    else
+    {
+        time_t now = ::time(NULL);
+        if (now / kRollPerSeconds * kRollPerSeconds != startOfPeriod_)
+        {
+            rollFile();
+        }
+    }
+}
+
+void LogFile::flush()
+{
+    if (fp_)
+    {
+        ::fflush(fp_);
+    }
+}
+
+bool LogFile::rollFile()
+{
+    time_t now = 0;
+    std::string filename = getLogFileName(basename_, &now);
+    time_t start = now / kRollPerSeconds * kRollPerSeconds;
+
+    // 同一秒内不重复滚动，避免文件名冲突
+    if (now > lastRoll_)
+    {
+        lastRoll_ = now;
+        startOfPeriod_ = start;
+        writtenBytes_ = 0;
+        if (fp_)
+        {
+            ::fclose(fp_);
+        }
+        fp_ = ::fopen(filename.c_str(), "ae"); // 'e' 即 O_CLOEXEC
+        if (fp_ == nullptr)
+        {
+            fprintf(stderr, "LogFile::rollFile() open %s failed\n", filename.c_str());
+            return false;
+        }
+        ::setbuffer(fp_, buffer_, sizeof buffer_);
+        return true;
+    }
+    return false;
+}
+
+std::string LogFile::getLogFileName(const std::string& basename, time_t* now)
+{
+    char buf[64] = {0};
+    *now = ::time(NULL);
+    tm tm_time;
+    localtime_r(now, &tm_time);
+    snprintf(buf, sizeof buf, ".%04d%02d%02d-%02d%02d%02d.%d.log",
+        tm_time.tm_year + 1900,
+        tm_time.tm_mon + 1,
+        tm_time.tm_mday,
+        tm_time.tm_hour,
+        tm_time.tm_min,
+        tm_time.tm_sec,
+        ::getpid());
+    return basename + buf;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <string>
+#include <cstdio>
+#include <ctime>
+#include <sys/types.h>
+
+/**
+ * 滚动日志文件，文件超过rollSize字节或者跨天时创建新文件
+ * 只在AsyncLogging的后台线程中使用，不加锁
+ * 文件名：basename.20240423-024545.pid.log
+*/
+class LogFile : noncopyable
+{
+public:
+    LogFile(const std::string& basename, off_t rollSize);
+    ~LogFile();
+
+    void append(const char* logline, size_t len);
+    void flush();
+    bool rollFile();
+
+private:
+    static std::string getLogFileName(const std::string& basename, time_t* now);
+
+    static const int kRollPerSeconds = 60 * 60 * 24;
+    static const size_t kFileBufferSize = 64 * 1024;
+
+    const std::string basename_;
+    const off_t rollSize_;
+
+    FILE* fp_;
+    off_t writtenBytes_;
+    time_t startOfPeriod_; // 当前文件所在那一天的0点
+    time_t lastRoll_;
+    char buffer_[kFileBufferSize]; // 文件的用户态缓冲区
+};
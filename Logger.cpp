@@ -1,7 +1,25 @@
 #include "Logger.h"
 #include "Timestamp.h"
 
-#include <iostream>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+// 默认输出到stdout，不再每条日志都flush
+static void defaultOutput(const char* msg, size_t len)
+{
+    ::fwrite(msg, 1, len, stdout);
+}
+
+static void defaultFlush()
+{
+    ::fflush(stdout);
+}
+
+static Logger::OutputFunc g_output = defaultOutput;
+static Logger::FlushFunc g_flush = defaultFlush;
+
+std::atomic_int Logger::logLevel_(INFO);
 
 // 获取唯一的实例对象
 Logger& Logger::instance() {
@@ -9,30 +27,46 @@ Logger& Logger::instance() {
     return logger;
 }
 
-void Logger::setLogLevel(int level) {
-    logLevel_ = level;
+void Logger::setOutput(OutputFunc out) {
+    g_output = out;
+}
+
+void Logger::setFlush(FlushFunc flush) {
+    g_flush = flush;
 }
 
-void Logger::log(std::string msg) {
-    switch (logLevel_)
+void Logger::log(int level, const char* logmsgFormat, ...) {
+    static const char* const kLevelName[NUM_LOG_LEVELS] = {
+        "[DEBUG]",
+        "[INFO]",
+        "[ERROR]",
+        "[FATAL]",
+    };
+    const char* name = (level >= 0 && level < NUM_LOG_LEVELS) ? kLevelName[level] : "";
+
+    // 打印时间和msg，直接格式化到同一块栈缓冲区中，一次交给输出后端
+    // 时间的秒以上部分按线程缓存，不会每条日志都调用localtime
+    char line[1280];
+    size_t len = strlen(name);
+    memcpy(line, name, len);
+    len += Timestamp::now().formatTo(line + len, true);
+    memcpy(line + len, " : ", 3);
+    len += 3;
+
+    va_list args;
+    va_start(args, logmsgFormat);
+    // 留一个字节给换行
+    int m = vsnprintf(line + len, sizeof line - len - 1, logmsgFormat, args);
+    va_end(args);
+    if (m > 0)
     {
-    case INFO:
-        std::cout << "[INFO]";
-        break;
-    case ERROR:
-        std::cout << "[ERROR]";
-        break;
-    case FATAL:
-        std::cout << "[FATAL]";
-        break;
-    case DEBUG:
-        std::cout << "[DEBUG]";
-        break;
-    default:
-        break;
+        len += static_cast<size_t>(m) < sizeof line - len - 1 ? static_cast<size_t>(m) : sizeof line - len - 2;
     }
+    line[len++] = '\n';
+    g_output(line, len);
 
-    // 打印时间和msg
-    std::cout << Timestamp::now().toString() << " : " << msg << std::endl;
-
-}
\ No newline at end of file
+    if (level == FATAL)
+    {
+        g_flush();
+    }
+}
@@ -1,74 +1,106 @@
 #pragma once
 #include "noncopyable.h"
 
+#include <atomic>
 #include <string>
+#include <stdlib.h>
 
-// LOG_INFO("%s, %d", arg1, arg2)
-#define LOG_INFO(logmsgFormat, ...) \
+// 定义日志的级别，数值越大越严重
+// DEBUG    INFO    ERROR     FATAL
+// 调试      正常     错误       失败
+enum LogLevel {
+    DEBUG,
+    INFO,
+    ERROR,
+    FATAL,
+    NUM_LOG_LEVELS
+};
+
+/**
+ * 编译期的最低日志级别，低于该级别的LOG_XXX宏展开为if (false)中的空调用，参数不会求值，
+ * 但参数仍然算作被使用，格式串也照样检查，换一个级别编译不会多出警告
+ * 预处理器无法比较枚举，所以用数字表示，和LogLevel一一对应
+ * 默认只有定义了MUDUBUG才编译DEBUG日志，也可以 -DMYMUDUO_MIN_LOG_LEVEL=2 只保留ERROR和FATAL
+*/
+#define MYMUDUO_LOG_LEVEL_DEBUG 0
+#define MYMUDUO_LOG_LEVEL_INFO  1
+#define MYMUDUO_LOG_LEVEL_ERROR 2
+
+#ifndef MYMUDUO_MIN_LOG_LEVEL
+#ifdef MUDUBUG
+#define MYMUDUO_MIN_LOG_LEVEL MYMUDUO_LOG_LEVEL_DEBUG
+#else
+#define MYMUDUO_MIN_LOG_LEVEL MYMUDUO_LOG_LEVEL_INFO
+#endif
+#endif
+
+// 先检查运行期的日志级别，被过滤掉的日志只有一次分支判断，不会格式化
+#define LOG_IMPL(level, logmsgFormat, ...) \
     do { \
-        Logger& logger = Logger::instance(); \
-        logger.setLogLevel(INFO); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
+        if (Logger::isEnabled(level)) \
+        { \
+            Logger::instance().log(level, logmsgFormat, ##__VA_ARGS__); \
+        } \
     } while(0)
 
-#define LOG_ERROR(logmsgFormat, ...) \
+#define LOG_DISABLED(logmsgFormat, ...) \
     do { \
-        Logger& logger = Logger::instance(); \
-        logger.setLogLevel(ERROR); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
+        if (false) \
+        { \
+            Logger::checkFormat(logmsgFormat, ##__VA_ARGS__); \
+        } \
     } while(0)
 
+// LOG_INFO("%s, %d", arg1, arg2)
+#if MYMUDUO_MIN_LOG_LEVEL <= MYMUDUO_LOG_LEVEL_INFO
+#define LOG_INFO(logmsgFormat, ...) LOG_IMPL(INFO, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_INFO(logmsgFormat, ...) LOG_DISABLED(logmsgFormat, ##__VA_ARGS__)
+#endif
+
+#if MYMUDUO_MIN_LOG_LEVEL <= MYMUDUO_LOG_LEVEL_ERROR
+#define LOG_ERROR(logmsgFormat, ...) LOG_IMPL(ERROR, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(logmsgFormat, ...) LOG_DISABLED(logmsgFormat, ##__VA_ARGS__)
+#endif
+
+// FATAL日志不受日志级别影响，记录之后退出进程
 #define LOG_FATAL(logmsgFormat, ...) \
     do { \
-        Logger& logger = Logger::instance(); \
-        logger.setLogLevel(FATAL); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
+        Logger::instance().log(FATAL, logmsgFormat, ##__VA_ARGS__); \
         exit(-1); \
     } while(0)
 
-#ifdef MUDUBUG
-#define LOG_DEBUG(logmsgFormat, ...) \
-    do { \
-        Logger& logger = Logger::instance(); \
-        logger.setLogLevel(DEBUG); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
-    } while(0)
+#if MYMUDUO_MIN_LOG_LEVEL <= MYMUDUO_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(logmsgFormat, ...) LOG_IMPL(DEBUG, logmsgFormat, ##__VA_ARGS__)
 #else
-#define LOG_DEBUG(logmsgFormat, ...)
+#define LOG_DEBUG(logmsgFormat, ...) LOG_DISABLED(logmsgFormat, ##__VA_ARGS__)
 #endif
 
-// 定义日志的级别
-// INFO    ERROR     FATAL    DEBUG
-// 正常     错误       失败     调试
-enum LogLevel {
-    INFO,
-    ERROR,
-    FATAL,
-    DEBUG
-};
-
 class Logger : noncopyable {
 // 禁止拷贝和赋值
 public:
     // 获取日志的实例对象
     static Logger& instance();
 
-    // 定义文件级别
-    void setLogLevel(int level);
+    // 设置全局的日志级别，低于该级别的日志被丢弃，线程安全
+    static void setLogLevel(int level) { logLevel_.store(level, std::memory_order_relaxed); }
+    static int logLevel() { return logLevel_.load(std::memory_order_relaxed); }
+    static bool isEnabled(int level) { return level >= logLevel(); }
+
+    // 写日志，日志级别由调用方传入
+    void log(int level, const char* logmsgFormat, ...) __attribute__((format(printf, 3, 4)));
+    // 什么也不做，只给编译期去掉的日志检查格式串
+    static void checkFormat(const char* /*logmsgFormat*/, ...) __attribute__((format(printf, 1, 2))) {}
 
-    // 写日志
-    void log(std::string msg);
+    // 日志的输出目的地，默认写到stdout，可以替换为AsyncLogging等后端
+    using OutputFunc = void (*)(const char* msg, size_t len);
+    using FlushFunc = void (*)();
+    static void setOutput(OutputFunc out);
+    static void setFlush(FlushFunc flush);
 
 private:
-    int logLevel_;
+    static std::atomic_int logLevel_;
 
     // 私有构造函数确保不能外部创建实例
     Logger(){}
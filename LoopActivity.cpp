@@ -0,0 +1,90 @@
+#include "LoopActivity.h"
+
+#include <sys/epoll.h>
+
+LoopActivity::LoopActivity()
+    : seq_(0)
+    , iterationStart_(0)
+    , callbackStart_(0)
+    , fd_(-1)
+    , revents_(0)
+{
+    for (size_t i = 0; i < kNameSize; ++i)
+    {
+        name_[i].store('\0', std::memory_order_relaxed);
+    }
+}
+
+void LoopActivity::begin(uint64_t nanos, int fd, int revents, const std::string& name)
+{
+    // 只有loop线程写，seq_不需要读改写
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    callbackStart_.store(nanos, std::memory_order_relaxed);
+    fd_.store(fd, std::memory_order_relaxed);
+    revents_.store(revents, std::memory_order_relaxed);
+    size_t len = name.size() < kNameSize - 1 ? name.size() : kNameSize - 1;
+    for (size_t i = 0; i < len; ++i)
+    {
+        name_[i].store(name[i], std::memory_order_relaxed);
+    }
+    name_[len].store('\0', std::memory_order_relaxed);
+
+    seq_.store(seq + 2, std::memory_order_release);
+}
+
+LoopActivity::Snapshot LoopActivity::snapshot() const
+{
+    Snapshot s;
+    uint32_t before;
+    uint32_t after;
+    do
+    {
+        before = seq_.load(std::memory_order_acquire);
+        s.callbackStart = callbackStart_.load(std::memory_order_relaxed);
+        s.fd = fd_.load(std::memory_order_relaxed);
+        s.revents = revents_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < kNameSize; ++i)
+        {
+            s.name[i] = name_[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = seq_.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    s.name[kNameSize - 1] = '\0';
+    s.iterationStart = iterationStart_.load(std::memory_order_relaxed);
+    return s;
+}
+
+std::string LoopActivity::Snapshot::callbackType() const
+{
+    if (revents == kPendingFunctor)
+    {
+        return "pending functor";
+    }
+    // 和Channel::handleEventWithGuard的判断一致
+    std::string type;
+    if ((revents & EPOLLHUP) && !(revents & EPOLLIN))
+    {
+        type += "close|";
+    }
+    if (revents & EPOLLERR)
+    {
+        type += "error|";
+    }
+    if (revents & (EPOLLIN | EPOLLPRI))
+    {
+        type += "read|";
+    }
+    if (revents & EPOLLOUT)
+    {
+        type += "write|";
+    }
+    if (!type.empty())
+    {
+        type.pop_back();
+    }
+    return type;
+}
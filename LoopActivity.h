@@ -0,0 +1,49 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * EventLoop当前正在执行的回调：fd、名字（连接名等）、回调类型和开始时间
+ * loop线程在每个回调开始时写入，看门狗线程用seqlock读取一份一致的拷贝，不会访问Channel本身
+ * 时间都是LoopMetrics::nowNanos()的纳秒
+*/
+class LoopActivity : noncopyable
+{
+public:
+    static const size_t kNameSize = 64;
+    // 不是Channel事件的回调用负数表示
+    static const int kPendingFunctor = -1;
+
+    struct Snapshot
+    {
+        uint64_t iterationStart; // 本轮开始处理事件的时间，0表示在poll中等待
+        uint64_t callbackStart; // 最近一个回调开始的时间
+        int fd;
+        int revents; // Channel的revents，或者kPendingFunctor
+        char name[kNameSize];
+
+        // 回调类型的可读描述，例如 "read|write"、"pending functor"
+        std::string callbackType() const;
+    };
+
+    LoopActivity();
+
+    // 以下只在loop线程中调用
+    void setIterationStart(uint64_t nanos) { iterationStart_.store(nanos, std::memory_order_relaxed); }
+    void begin(uint64_t nanos, int fd, int revents, const std::string& name);
+
+    // 任意线程调用，loop正在写入时重试
+    Snapshot snapshot() const;
+
+private:
+    std::atomic<uint32_t> seq_; // 奇数表示正在写入
+    std::atomic<uint64_t> iterationStart_;
+    std::atomic<uint64_t> callbackStart_;
+    std::atomic<int> fd_;
+    std::atomic<int> revents_;
+    std::atomic<char> name_[kNameSize];
+};
@@ -0,0 +1,147 @@
+#include "LoopMetrics.h"
+
+#include <stdio.h>
+
+Histogram::Snapshot::Snapshot()
+    : count(0)
+    , sum(0)
+    , max(0)
+{
+    for (int i = 0; i < kBuckets; ++i)
+    {
+        buckets[i] = 0;
+    }
+}
+
+void Histogram::Snapshot::merge(const Snapshot& other)
+{
+    count += other.count;
+    sum += other.sum;
+    if (other.max > max)
+    {
+        max = other.max;
+    }
+    for (int i = 0; i < kBuckets; ++i)
+    {
+        buckets[i] += other.buckets[i];
+    }
+}
+
+uint64_t Histogram::Snapshot::percentile(double p) const
+{
+    // 各个计数是分别读取的，以桶的总数为准
+    uint64_t total = 0;
+    for (int i = 0; i < kBuckets; ++i)
+    {
+        total += buckets[i];
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(p * total);
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i)
+    {
+        seen += buckets[i];
+        if (seen > rank)
+        {
+            uint64_t upper = i == 0 ? 0 : (1ULL << i) - 1;
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+Histogram::Histogram()
+    : count_(0)
+    , sum_(0)
+    , max_(0)
+{
+    for (int i = 0; i < kBuckets; ++i)
+    {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+Histogram::Snapshot Histogram::snapshot() const
+{
+    Snapshot s;
+    s.count = count_.load(std::memory_order_relaxed);
+    s.sum = sum_.load(std::memory_order_relaxed);
+    s.max = max_.load(std::memory_order_relaxed);
+    for (int i = 0; i < kBuckets; ++i)
+    {
+        s.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    return s;
+}
+
+LoopMetrics::Snapshot::Snapshot()
+    : iterations(0)
+    , bytesRead(0)
+    , bytesWritten(0)
+{
+}
+
+void LoopMetrics::Snapshot::merge(const Snapshot& other)
+{
+    iterations += other.iterations;
+    bytesRead += other.bytesRead;
+    bytesWritten += other.bytesWritten;
+    pollWait.merge(other.pollWait);
+    eventsPerPoll.merge(other.eventsPerPoll);
+    handleEvent.merge(other.handleEvent);
+    functorsPerBatch.merge(other.functorsPerBatch);
+    functorBatch.merge(other.functorBatch);
+}
+
+static void appendHistogram(std::string* out, const char* name, const Histogram::Snapshot& h)
+{
+    char buf[256];
+    snprintf(buf, sizeof buf, "%-18s count=%llu mean=%.1f p50=%llu p99=%llu max=%llu\n",
+        name,
+        static_cast<unsigned long long>(h.count),
+        h.mean(),
+        static_cast<unsigned long long>(h.percentile(0.50)),
+        static_cast<unsigned long long>(h.percentile(0.99)),
+        static_cast<unsigned long long>(h.max));
+    out->append(buf);
+}
+
+std::string LoopMetrics::Snapshot::toString() const
+{
+    char buf[128];
+    snprintf(buf, sizeof buf, "iterations=%llu bytesRead=%llu bytesWritten=%llu\n",
+        static_cast<unsigned long long>(iterations),
+        static_cast<unsigned long long>(bytesRead),
+        static_cast<unsigned long long>(bytesWritten));
+    std::string out(buf);
+    appendHistogram(&out, "pollWait(ns)", pollWait);
+    appendHistogram(&out, "eventsPerPoll", eventsPerPoll);
+    appendHistogram(&out, "handleEvent(ns)", handleEvent);
+    appendHistogram(&out, "functorsPerBatch", functorsPerBatch);
+    appendHistogram(&out, "functorBatch(ns)", functorBatch);
+    return out;
+}
+
+LoopMetrics::LoopMetrics()
+    : iterations_(0)
+    , bytesRead_(0)
+    , bytesWritten_(0)
+{
+}
+
+LoopMetrics::Snapshot LoopMetrics::snapshot() const
+{
+    Snapshot s;
+    s.iterations = iterations_.load(std::memory_order_relaxed);
+    s.bytesRead = bytesRead_.load(std::memory_order_relaxed);
+    s.bytesWritten = bytesWritten_.load(std::memory_order_relaxed);
+    s.pollWait = pollWait_.snapshot();
+    s.eventsPerPoll = eventsPerPoll_.snapshot();
+    s.handleEvent = handleEvent_.snapshot();
+    s.functorsPerBatch = functorsPerBatch_.snapshot();
+    s.functorBatch = functorBatch_.snapshot();
+    return s;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <time.h>
+
+/**
+ * 按2的幂分桶的直方图，第i个桶统计[2^(i-1), 2^i)的值，第0个桶统计0
+ * 只有一个线程（loop线程）写，不需要原子的读改写；其他线程可以随时snapshot
+*/
+class Histogram : noncopyable
+{
+public:
+    static const int kBuckets = 40;
+
+    struct Snapshot
+    {
+        uint64_t count;
+        uint64_t sum;
+        uint64_t max;
+        uint64_t buckets[kBuckets];
+
+        Snapshot();
+        void merge(const Snapshot& other);
+        double mean() const { return count ? static_cast<double>(sum) / count : 0; }
+        // 第p（0~1）分位所在桶的上界
+        uint64_t percentile(double p) const;
+    };
+
+    Histogram();
+
+    void record(uint64_t value)
+    {
+        int index = value == 0 ? 0 : 64 - __builtin_clzll(value);
+        if (index >= kBuckets)
+        {
+            index = kBuckets - 1;
+        }
+        increase(buckets_[index], 1);
+        increase(count_, 1);
+        increase(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed))
+        {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    Snapshot snapshot() const;
+
+private:
+    static void increase(std::atomic<uint64_t>& counter, uint64_t n)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_;
+    std::atomic<uint64_t> max_;
+    std::atomic<uint64_t> buckets_[kBuckets];
+};
+
+/**
+ * 一个EventLoop的运行统计，由loop线程在热路径上记录，其他线程通过snapshot读取，不需要停下loop
+ * 时间的单位都是纳秒
+*/
+class LoopMetrics : noncopyable
+{
+public:
+    struct Snapshot
+    {
+        uint64_t iterations; // loop的轮数
+        uint64_t bytesRead; // TcpConnection从socket读到的字节数
+        uint64_t bytesWritten; // TcpConnection写到socket的字节数
+        Histogram::Snapshot pollWait; // 每次poll阻塞的时间
+        Histogram::Snapshot eventsPerPoll; // 每次poll返回的事件数
+        Histogram::Snapshot handleEvent; // 每次Channel::handleEvent的耗时
+        Histogram::Snapshot functorsPerBatch; // 每次doPendingFunctors执行的回调数
+        Histogram::Snapshot functorBatch; // 每次doPendingFunctors的耗时
+
+        Snapshot();
+        // 把另一个loop的统计累加进来
+        void merge(const Snapshot& other);
+        // 多行的可读文本
+        std::string toString() const;
+    };
+
+    LoopMetrics();
+
+    static uint64_t nowNanos()
+    {
+        timespec ts;
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    // 以下只在loop线程中调用
+    void recordPoll(uint64_t waitNanos, size_t events)
+    {
+        iterations_.store(iterations_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        pollWait_.record(waitNanos);
+        eventsPerPoll_.record(events);
+    }
+    void recordHandleEvent(uint64_t nanos) { handleEvent_.record(nanos); }
+    void recordFunctors(size_t count, uint64_t nanos)
+    {
+        functorsPerBatch_.record(count);
+        functorBatch_.record(nanos);
+    }
+    void addBytesRead(size_t n) { bytesRead_.store(bytesRead_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    void addBytesWritten(size_t n) { bytesWritten_.store(bytesWritten_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+
+    // 线程安全
+    Snapshot snapshot() const;
+
+private:
+    std::atomic<uint64_t> iterations_;
+    std::atomic<uint64_t> bytesRead_;
+    std::atomic<uint64_t> bytesWritten_;
+    Histogram pollWait_;
+    Histogram eventsPerPoll_;
+    Histogram handleEvent_;
+    Histogram functorsPerBatch_;
+    Histogram functorBatch_;
+};
@@ -0,0 +1,82 @@
+#include "LoopWatchdog.h"
+#include "EventLoop.h"
+#include "LoopMetrics.h"
+#include "Logger.h"
+
+#include <chrono>
+
+static void defaultStallCallback(EventLoop* loop, const LoopActivity::Snapshot& activity, double stalledSeconds)
+{
+    LOG_ERROR("EventLoop %p stalled for %.3f ms in %s callback of fd=%d [%s] \n",
+        loop, stalledSeconds * 1000, activity.callbackType().c_str(), activity.fd, activity.name);
+}
+
+LoopWatchdog::LoopWatchdog(double stallSeconds)
+    : stallNanos_(static_cast<uint64_t>(stallSeconds * 1e9))
+    , stallCallback_(defaultStallCallback)
+    , thread_(std::bind(&LoopWatchdog::threadFunc, this), "LoopWatchdog")
+    , running_(false)
+{
+}
+
+LoopWatchdog::~LoopWatchdog()
+{
+    stop();
+}
+
+void LoopWatchdog::watch(EventLoop* loop)
+{
+    loop->enableActivityTracking();
+    loops_.push_back(Watched{ loop, 0 });
+}
+
+void LoopWatchdog::start()
+{
+    running_ = true;
+    thread_.start();
+}
+
+void LoopWatchdog::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_)
+        {
+            return;
+        }
+        running_ = false;
+    }
+    cond_.notify_one();
+    thread_.join();
+}
+
+void LoopWatchdog::threadFunc()
+{
+    // 检查间隔取超时时间的1/4，卡顿最多晚1/4个超时时间被发现
+    const std::chrono::nanoseconds interval(stallNanos_ / 4 > 0 ? stallNanos_ / 4 : 1);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_)
+    {
+        cond_.wait_for(lock, interval);
+        if (running_)
+        {
+            check();
+        }
+    }
+}
+
+void LoopWatchdog::check()
+{
+    uint64_t now = LoopMetrics::nowNanos();
+    for (Watched& w : loops_)
+    {
+        LoopActivity::Snapshot activity = w.loop->activity().snapshot();
+        uint64_t start = activity.iterationStart;
+        if (start == 0 || start == w.reportedIteration || now < start || now - start < stallNanos_)
+        {
+            continue;
+        }
+        w.reportedIteration = start;
+        stallCallback_(w.loop, activity, (now - start) / 1e9);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Thread.h"
+#include "LoopActivity.h"
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class EventLoop;
+
+/**
+ * 看门狗线程：定期检查各个EventLoop，一轮事件处理超过stallSeconds还没有结束时，
+ * 报告loop正卡在哪个回调上（fd、连接名、回调类型），每轮卡顿只报告一次
+ * 默认记录ERROR日志，也可以设置自己的回调
+*/
+class LoopWatchdog : noncopyable
+{
+public:
+    // stalledSeconds是到检测时这一轮已经持续的时间
+    using StallCallback = std::function<void(EventLoop*, const LoopActivity::Snapshot&, double stalledSeconds)>;
+
+    explicit LoopWatchdog(double stallSeconds);
+    ~LoopWatchdog();
+
+    // 需要在start之前调用，loop必须比看门狗活得久
+    void watch(EventLoop* loop);
+    void setStallCallback(const StallCallback& cb) { stallCallback_ = cb; }
+
+    void start();
+    void stop();
+
+private:
+    struct Watched
+    {
+        EventLoop* loop;
+        uint64_t reportedIteration; // 已经报告过的那一轮的开始时间
+    };
+
+    void threadFunc();
+    void check();
+
+    const uint64_t stallNanos_;
+    std::vector<Watched> loops_;
+    StallCallback stallCallback_;
+
+    Thread thread_;
+    bool running_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
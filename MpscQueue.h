@@ -0,0 +1,166 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <cstddef>
+
+/**
+ * 无锁的多生产者单消费者队列（Vyukov intrusive MPSC）
+ * 生产者：一次原子exchange加一次store，任意线程都可以push
+ * 消费者：只能是一个线程，EventLoop中就是loop所在的线程
+ *
+ * 生产者在exchange之后、链接next之前的极短时间内，消费者会看到链表“断开”，
+ * 这时消费者自旋等待该生产者完成链接，保证不会漏掉已经push的元素
+*/
+struct MpscQueueTester;
+
+template <typename T>
+class MpscQueue : noncopyable
+{
+public:
+    MpscQueue()
+        : head_(&stub_)
+        , tail_(&stub_)
+    {
+        stub_.next.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~MpscQueue()
+    {
+        T value;
+        while (pop(&value))
+        {
+        }
+    }
+
+    // 多个线程可以同时调用
+    void push(T value)
+    {
+        Node* node = new Node(std::move(value));
+        // exchange与消费者读取head_之间必须是顺序一致的，见EventLoop::queueInLoop
+        Node* prev = head_.exchange(node, std::memory_order_seq_cst);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // 只能在消费者线程中调用，队列为空返回false
+    bool pop(T* value)
+    {
+        Node* node = popNode();
+        if (node == nullptr)
+        {
+            return false;
+        }
+        *value = std::move(node->value);
+        delete node;
+        return true;
+    }
+
+    // 只能在消费者线程中调用，依次对调用时刻已经入队的元素执行f，返回处理的个数
+    // f执行期间新push的元素留到下一次处理，和原来swap出vector再执行的语义相同
+    // head_指向stub时队列不一定为空：popNode取最后一个元素时有生产者并发push，
+    // pushStub之后队列是 新元素 -> stub，这时以stub为界，取到stub之前的元素为止
+    template <typename Func>
+    size_t consumeAll(Func&& f)
+    {
+        if (empty())
+        {
+            return 0;
+        }
+        Node* last = head_.load(std::memory_order_seq_cst);
+        size_t n = 0;
+        Node* node;
+        while ((node = popNode()) != nullptr)
+        {
+            bool done = (node == last) || (last == &stub_ && tail_ == &stub_);
+            f(std::move(node->value));
+            delete node;
+            ++n;
+            if (done)
+            {
+                break;
+            }
+        }
+        return n;
+    }
+
+    // 只能在消费者线程中调用
+    bool empty() const
+    {
+        return tail_ == &stub_
+            && stub_.next.load(std::memory_order_acquire) == nullptr
+            && head_.load(std::memory_order_seq_cst) == &stub_;
+    }
+
+private:
+    // example/mpsctest用来让生产者停在exchange和链接next之间
+    friend struct MpscQueueTester;
+
+    struct Node
+    {
+        Node() = default;
+        explicit Node(T v) : value(std::move(v)), next(nullptr) {}
+
+        T value;
+        std::atomic<Node*> next;
+    };
+
+    // 取出队首节点，由调用方delete
+    Node* popNode()
+    {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_)
+        {
+            if (next == nullptr)
+            {
+                if (head_.load(std::memory_order_seq_cst) == &stub_)
+                {
+                    return nullptr;
+                }
+                next = waitNext(tail);
+            }
+            // 跳过stub节点
+            tail_ = next;
+            tail = next;
+            next = tail->next.load(std::memory_order_acquire);
+        }
+
+        if (next == nullptr)
+        {
+            if (tail == head_.load(std::memory_order_seq_cst))
+            {
+                // tail是最后一个元素，把stub重新放回队尾才能取出tail
+                pushStub();
+            }
+            // 否则有生产者正在push，等它链接完成
+            next = waitNext(tail);
+        }
+
+        tail_ = next;
+        return tail;
+    }
+
+    void pushStub()
+    {
+        stub_.next.store(nullptr, std::memory_order_relaxed);
+        Node* prev = head_.exchange(&stub_, std::memory_order_seq_cst);
+        prev->next.store(&stub_, std::memory_order_release);
+    }
+
+    static Node* waitNext(Node* node)
+    {
+        Node* next;
+        while ((next = node->next.load(std::memory_order_acquire)) == nullptr)
+        {
+            std::this_thread::yield();
+        }
+        return next;
+    }
+
+    std::atomic<Node*> head_; // 生产者从head_插入
+    Node* tail_; // 消费者从tail_取出，只有消费者线程访问
+    Node stub_;
+};
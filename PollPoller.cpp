@@ -0,0 +1,127 @@
+#include "PollPoller.h"
+#include "Logger.h"
+#include "Channel.h"
+
+#include <errno.h>
+#include <sys/epoll.h>
+
+PollPoller::PollPoller(EventLoop* loop)
+    : Poller(loop)
+    , edgeTriggeredChannels_(0)
+{
+}
+
+PollPoller::~PollPoller() = default;
+
+// EPOLLIN/EPOLLOUT等和POLLIN/POLLOUT的取值相同，可以直接使用
+short PollPoller::pollEvents(const Channel* channel)
+{
+    int events = channel->events() & ~EPOLLET;
+    if (channel->edgeTriggered() && !channel->isWriting())
+    {
+        events &= ~POLLOUT;
+    }
+    return static_cast<short>(events);
+}
+
+Timestamp PollPoller::poll(int timeoutMs, ChannelList* activeChannels)
+{
+    LOG_DEBUG("func=%s, fd total count:%zu\n", __FUNCTION__, pollfds_.size());
+    if (edgeTriggeredChannels_ > 0)
+    {
+        for (size_t i = 0; i < pollfds_.size(); ++i)
+        {
+            Channel* channel = pollChannels_[i];
+            if (channel->edgeTriggered() && pollfds_[i].fd >= 0)
+            {
+                pollfds_[i].events = pollEvents(channel);
+            }
+        }
+    }
+
+    int numEvents = ::poll(pollfds_.data(), pollfds_.size(), timeoutMs);
+    int savedErrno = errno;
+    Timestamp now(Timestamp::now());
+
+    if (numEvents > 0)
+    {
+        LOG_DEBUG("%d events happened \n", numEvents);
+        fillActiveChannels(numEvents, activeChannels);
+    }
+    else if (numEvents < 0 && savedErrno != EINTR)
+    {
+        errno = savedErrno;
+        LOG_ERROR("PollPoller:poll()");
+    }
+    return now;
+}
+
+void PollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels) const
+{
+    for (size_t i = 0; i < pollfds_.size() && numEvents > 0; ++i)
+    {
+        if (pollfds_[i].revents > 0)
+        {
+            --numEvents;
+            Channel* channel = pollChannels_[i];
+            channel->set_revents(pollfds_[i].revents);
+            activeChannels->push_back(channel);
+        }
+    }
+}
+
+void PollPoller::updateChannel(Channel* channel)
+{
+    LOG_DEBUG("func-%s, fd=%d events=%d index=%d \n", __FUNCTION__, channel->fd(), channel->events(), channel->index());
+    if (channel->index() < 0)
+    {
+        // 新的Channel，追加到数组末尾
+        pollfd pfd;
+        pfd.fd = channel->fd();
+        pfd.events = pollEvents(channel);
+        pfd.revents = 0;
+        pollfds_.push_back(pfd);
+        pollChannels_.push_back(channel);
+        channel->set_index(static_cast<int>(pollfds_.size()) - 1);
+        channels_[pfd.fd] = channel;
+        if (channel->edgeTriggered())
+        {
+            ++edgeTriggeredChannels_;
+        }
+    }
+    else
+    {
+        pollfd& pfd = pollfds_[channel->index()];
+        pfd.events = pollEvents(channel);
+        pfd.revents = 0;
+        // 没有感兴趣的事件时让poll忽略该fd，fd取反之后一定是负数
+        pfd.fd = channel->isNoneEvent() ? -channel->fd() - 1 : channel->fd();
+    }
+}
+
+void PollPoller::removeChannel(Channel* channel)
+{
+    LOG_DEBUG("func-%s, fd=%d \n", __FUNCTION__, channel->fd());
+    int idx = channel->index();
+    if (idx < 0)
+    {
+        return;
+    }
+    channels_.erase(channel->fd());
+    if (channel->edgeTriggered())
+    {
+        --edgeTriggeredChannels_;
+    }
+
+    // 和最后一个元素交换之后删除，被换过来的Channel更新下标
+    size_t last = pollfds_.size() - 1;
+    if (static_cast<size_t>(idx) != last)
+    {
+        pollfds_[idx] = pollfds_[last];
+        pollChannels_[idx] = pollChannels_[last];
+        pollChannels_[idx]->set_index(idx);
+    }
+    pollfds_.pop_back();
+    pollChannels_.pop_back();
+    channel->set_index(-1);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Poller.h"
+#include "Timestamp.h"
+
+#include <vector>
+#include <poll.h>
+
+class Channel;
+
+/**
+ * poll(2)的使用，fd不多时每次调用的开销比epoll小
+ * pollfds_是紧凑的数组，Channel的index就是它在数组中的下标，
+ * 删除时和最后一个元素交换再pop_back，数组中没有空洞
+ * 没有感兴趣事件的Channel仍然留在数组中，fd取反让poll忽略它
+ *
+ * poll只有水平触发，边缘触发的Channel每次poll之前按isWriting()决定是否关心POLLOUT，
+ * 它们的读写都会进行到EAGAIN，水平触发不影响正确性
+*/
+class PollPoller : public Poller
+{
+public:
+    PollPoller(EventLoop* loop);
+    ~PollPoller() override;
+
+    Timestamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+
+private:
+    // 填写活跃的连接
+    void fillActiveChannels(int numEvents, ChannelList* activeChannels) const;
+    static short pollEvents(const Channel* channel);
+
+    using PollFdList = std::vector<pollfd>;
+
+    PollFdList pollfds_;
+    std::vector<Channel*> pollChannels_; // 和pollfds_一一对应
+    int edgeTriggeredChannels_;
+};
@@ -17,6 +17,15 @@ class Poller : noncopyable
 public:
     using ChannelList = std::vector<Channel*>;
 
+    // IO复用的实现
+    enum Backend
+    {
+        kDefault, // 由环境变量选择：MUDUO_USE_POLL使用poll，MUDUO_USE_IO_URING使用io_uring，否则使用epoll
+        kEPoll,
+        kPoll,
+        kIoUring, // 内核不支持时退回epoll
+    };
+
     Poller(EventLoop* loop);
     virtual ~Poller();
 
@@ -27,8 +36,16 @@ public:
 
     bool hasChannel(Channel* channel) const;
 
+    // 完成式accept，只有io_uring实现，其他实现返回false，调用方继续等可读事件再accept
+    // channel是监听socket的Channel：开启之后由内核accept连接，channel照常以可读事件通知，
+    // 回调中用takeAccepted取出accept好的fd
+    virtual bool enableMultishotAccept(Channel* /*channel*/) { return false; }
+    // 取出accept好的fd（出错时是负的errno）；channel不在完成式accept模式时返回false
+    virtual bool takeAccepted(Channel* /*channel*/, std::vector<int>* /*fds*/) { return false; }
+
     // 类似于单例模式，EventLoop通过该接口获取默认的IO复用的具体实现
     static Poller* newDefaultPoller(EventLoop* loop);
+    static Poller* newPoller(EventLoop* loop, Backend backend);
 
 protected:
     // map的key表示sockfd，val表示sockfd所属的Channel通道类型
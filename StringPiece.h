@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <string.h>
+#include <strings.h>
+
+/**
+ * 不持有内存的字符串视图，指向的数据由别处保证有效
+*/
+class StringPiece
+{
+public:
+    StringPiece()
+        : data_(nullptr)
+        , size_(0)
+    {
+    }
+
+    StringPiece(const char* data, size_t size)
+        : data_(data)
+        , size_(size)
+    {
+    }
+
+    StringPiece(const char* str)
+        : data_(str)
+        , size_(::strlen(str))
+    {
+    }
+
+    StringPiece(const std::string& str)
+        : data_(str.data())
+        , size_(str.size())
+    {
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+    char operator[](size_t i) const { return data_[i]; }
+
+    std::string toString() const { return std::string(data_, size_); }
+
+    bool operator==(const StringPiece& rhs) const
+    {
+        return size_ == rhs.size_ && ::memcmp(data_, rhs.data_, size_) == 0;
+    }
+    bool operator!=(const StringPiece& rhs) const { return !(*this == rhs); }
+
+    // 忽略大小写比较，用于HTTP头部的名字等
+    bool caseEqual(const StringPiece& rhs) const
+    {
+        return size_ == rhs.size_ && ::strncasecmp(data_, rhs.data_, size_) == 0;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+};
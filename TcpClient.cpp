@@ -0,0 +1,152 @@
+#include "TcpClient.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <strings.h>
+#include <sys/socket.h>
+
+static EventLoop* CheckLoopNotNULL(EventLoop* loop)
+{
+    if (loop == nullptr)
+    {
+        LOG_FATAL("%s:%s:%d TcpClient loop is null! \n", __FILE__, __FUNCTION__, __LINE__);
+    }
+    return loop;
+}
+
+// TcpClient析构之后连接才断开时使用，连接不再通知已经不存在的TcpClient
+static void removeConnection(EventLoop* loop, const TcpConnectionPtr& conn)
+{
+    loop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+TcpClient::TcpClient(EventLoop* loop, const InetAddress& serverAddr, const std::string& nameArg)
+    : loop_(CheckLoopNotNULL(loop))
+    , connector_(new Connector(loop, serverAddr))
+    , name_(nameArg)
+    , connectionCallback_(defaultConnectionCallback)
+    , messageCallback_(defaultMessageCallback)
+    , retry_(false)
+    , connect_(true)
+    , nextConnId_(1)
+{
+    connector_->setNewConnectionCallback(
+        std::bind(&TcpClient::newConnection, this, std::placeholders::_1));
+    connector_->setErrorCallback(
+        std::bind(&TcpClient::connectError, this, std::placeholders::_1));
+    LOG_INFO("TcpClient::TcpClient[%s] - connector %p \n", name_.c_str(), connector_.get());
+}
+
+TcpClient::~TcpClient()
+{
+    LOG_INFO("TcpClient::~TcpClient[%s] - connector %p \n", name_.c_str(), connector_.get());
+    TcpConnectionPtr conn;
+    bool unique = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        unique = connection_.unique();
+        conn = connection_;
+    }
+    if (conn)
+    {
+        // 连接可能比TcpClient活得久，把closeCallback换成不依赖TcpClient的版本
+        CloseCallback cb = std::bind(&::removeConnection, loop_, std::placeholders::_1);
+        loop_->runInLoop(std::bind(&TcpConnection::setCloseCallback, conn, cb));
+        if (unique)
+        {
+            conn->forceClose();
+        }
+    }
+    // 同时取消正在进行的连接和重试，Connector回调中的this之后不再使用
+    connector_->stop();
+}
+
+void TcpClient::connect()
+{
+    LOG_INFO("TcpClient::connect[%s] - connecting to %s \n",
+        name_.c_str(), connector_->serverAddress().toIpPort().c_str());
+    connect_ = true;
+    connector_->start();
+}
+
+void TcpClient::disconnect()
+{
+    connect_ = false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (connection_)
+    {
+        connection_->shutdown();
+    }
+}
+
+void TcpClient::stop()
+{
+    connect_ = false;
+    connector_->stop();
+}
+
+void TcpClient::newConnection(int sockfd)
+{
+    sockaddr_in peer;
+    sockaddr_in local;
+    socklen_t len = sizeof peer;
+    bzero(&peer, sizeof peer);
+    bzero(&local, sizeof local);
+    if (::getpeername(sockfd, (sockaddr*)&peer, &len) < 0)
+    {
+        LOG_ERROR("TcpClient::newConnection getpeername error %d \n", errno);
+    }
+    len = sizeof local;
+    if (::getsockname(sockfd, (sockaddr*)&local, &len) < 0)
+    {
+        LOG_ERROR("TcpClient::newConnection getsockname error %d \n", errno);
+    }
+    InetAddress peerAddr(peer);
+    InetAddress localAddr(local);
+
+    char buf[64] = {0};
+    snprintf(buf, sizeof buf, ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_);
+    ++nextConnId_;
+    std::string connName = name_ + buf;
+
+    TcpConnectionPtr conn(new TcpConnection(loop_, connName, sockfd, localAddr, peerAddr));
+    conn->SetConnectionCallback(connectionCallback_);
+    conn->setMessageCallback(messageCallback_);
+    conn->setWriteCompleteCallback(writeCompleteCallback_);
+    conn->setCloseCallback(
+        std::bind(&TcpClient::removeConnection, this, std::placeholders::_1));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection_ = conn;
+    }
+    conn->connectEstablised();
+}
+
+// Connector已经放弃，不会再有连接，enableRetry也不会重连
+void TcpClient::connectError(int err)
+{
+    LOG_ERROR("TcpClient::connectError[%s] - connect to %s failed, error %d \n",
+        name_.c_str(), connector_->serverAddress().toIpPort().c_str(), err);
+    connect_ = false;
+    if (connectErrorCallback_)
+    {
+        connectErrorCallback_(err);
+    }
+}
+
+void TcpClient::removeConnection(const TcpConnectionPtr& conn)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connection_.reset();
+    }
+    loop_->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+    if (retry_ && connect_)
+    {
+        LOG_INFO("TcpClient::removeConnection[%s] - Reconnecting to %s \n",
+            name_.c_str(), connector_->serverAddress().toIpPort().c_str());
+        connector_->restart();
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callback.h"
+#include "Connector.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "TcpConnection.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+/**
+ * 客户端，Connector建立连接之后在loop上创建普通的TcpConnection，和TcpServer的连接用法相同
+ * loop可以是TcpServer线程池中的subloop，出站连接和入站连接共用同一批loop线程
+ * 每个TcpClient最多一个连接；enableRetry之后连接断开会自动重连
+ * connect遇到EACCES、ENETDOWN这类不会重试的错误时停止连接，回调connectErrorCallback，之后可以再次connect
+*/
+class TcpClient : noncopyable
+{
+public:
+    // 参数是connect的errno，在loop线程中回调
+    using ConnectErrorCallback = std::function<void(int err)>;
+
+    TcpClient(EventLoop* loop, const InetAddress& serverAddr, const std::string& nameArg);
+    ~TcpClient();
+
+    void connect();
+    // 关闭写端，等对端关闭连接
+    void disconnect();
+    // 停止连接（包括正在进行的重试）
+    void stop();
+
+    TcpConnectionPtr connection() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return connection_;
+    }
+
+    EventLoop* getLoop() const { return loop_; }
+    const std::string& name() const { return name_; }
+    bool retry() const { return retry_; }
+    // 已建立的连接断开之后重新连接
+    void enableRetry() { retry_ = true; }
+    // 连接失败时重试的初始间隔和最大间隔，单位毫秒，需要在connect之前设置
+    void setRetryDelay(int initMs, int maxMs) { connector_->setRetryDelay(initMs, maxMs); }
+
+    // 以下回调不是线程安全的，需要在connect之前设置
+    void setConnectionCallback(const ConnectionCallback& cb) { connectionCallback_ = cb; }
+    void setMessageCallback(const MessageCallback& cb) { messageCallback_ = cb; }
+    void setWriteCompleteCallback(const WriteCompleteCallback& cb) { writeCompleteCallback_ = cb; }
+    void setConnectErrorCallback(const ConnectErrorCallback& cb) { connectErrorCallback_ = cb; }
+
+private:
+    // 在loop线程中调用
+    void newConnection(int sockfd);
+    void connectError(int err);
+    void removeConnection(const TcpConnectionPtr& conn);
+
+    EventLoop* loop_;
+    ConnectorPtr connector_;
+    const std::string name_;
+    ConnectionCallback connectionCallback_;
+    MessageCallback messageCallback_;
+    WriteCompleteCallback writeCompleteCallback_;
+    ConnectErrorCallback connectErrorCallback_;
+    std::atomic_bool retry_;
+    std::atomic_bool connect_;
+    int nextConnId_; // 只在loop线程中访问
+    mutable std::mutex mutex_;
+    TcpConnectionPtr connection_; // 由mutex_保护
+};
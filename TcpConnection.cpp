@@ -3,12 +3,16 @@
 #include "Socket.h"
 #include "Channel.h"
 #include "EventLoop.h"
+#include "TimingWheel.h"
 
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <strings.h>
 #include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 static EventLoop* CheckLoopNotNULL(EventLoop* loop)
 {
@@ -20,6 +24,17 @@ static EventLoop* CheckLoopNotNULL(EventLoop* loop)
     return loop;
 }
 
+void defaultConnectionCallback(const TcpConnectionPtr& conn)
+{
+    LOG_INFO("%s -> %s is %s \n", conn->localAddress().toIpPort().c_str(),
+        conn->peerAddress().toIpPort().c_str(), conn->connected() ? "UP" : "DOWN");
+}
+
+void defaultMessageCallback(const TcpConnectionPtr&, Buffer* buffer, Timestamp)
+{
+    buffer->retrieveAll();
+}
+
 TcpConnection::TcpConnection(EventLoop* loop,
                                 const std::string &nameArg,
                                 int sockfd,
@@ -34,13 +49,23 @@ TcpConnection::TcpConnection(EventLoop* loop,
     , localAddr_(localAddr)
     , peerAddr_(peerAddr)
     , highWaterMark_(64*1024*1024)
+    , idleTimeout_(0.0)
+    , inputBuffer_(loop->bufferPool())
+    , outputBuffer_(loop->bufferPool())
+    , reportedPendingBytes_(0)
+    , backpressureHigh_(0)
+    , backpressureLow_(0)
+    , sourcePaused_(false)
 {
+    channel_->setName(name_);
     channel_->setReadEventCallback(std::bind(&TcpConnection::handleRead, this, std::placeholders::_1));
     channel_->setWriteCallback(std::bind(&TcpConnection::handleWrite, this));
     channel_->setCloseCallback(std::bind(&TcpConnection::handleClose, this));
     channel_->setErrorCallback(std::bind(&TcpConnection::handleError, this));
     LOG_INFO("TcpConnection::ctor[%s] at fd=%d\n", name_.c_str(), sockfd);
     socket_->setKeepAlive(true);
+    // 在选择loop的线程中就计入，连续建立的连接能看到前面的连接；connectDestroyed时减掉
+    loop_->addConnections(1);
 }
 
 TcpConnection::~TcpConnection()
@@ -48,20 +73,53 @@ TcpConnection::~TcpConnection()
     LOG_INFO("TcpConnection::dtor[%s] at fd=%d state=%d\n", name_.c_str(), channel_->fd(), (int)state_);
 }
 
+void TcpConnection::setEdgeTriggered(bool on)
+{
+    channel_->setEdgeTriggered(on);
+}
+
+/**
+ * 水平触发：每次可读事件只读一次，没读完的数据Poller会再次通知
+ * 边缘触发：一直读到EAGAIN才会再有通知；读够kMaxBytesPerEvent还没读完时让出loop，
+ * 先处理其他连接的事件，剩下的在queueInLoop的回调中继续读
+*/
 void TcpConnection::handleRead(Timestamp receiveTime)
 {
+    const bool edgeTriggered = channel_->edgeTriggered();
     int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
-    if (n > 0)
+    size_t total = 0;
+    ssize_t n = 0;
+    do
+    {
+        n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+        if (n > 0)
+        {
+            total += n;
+        }
+    } while (edgeTriggered && n > 0 && total < kMaxBytesPerEvent);
+
+    if (total > 0)
     {
+        loop_->metrics().addBytesRead(total);
+        touch(receiveTime);
         // 已建立连接的用户，有可读事件发生，调用用户传入的回调操作
         messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+        // 偶尔的大请求把inputBuffer_撑大之后，不要一直占着大块内存
+        inputBuffer_.shrinkIfOversized();
+    }
+
+    if (n > 0)
+    {
+        if (edgeTriggered)
+        {
+            loop_->queueInLoop(std::bind(&TcpConnection::resumeRead, shared_from_this(), receiveTime));
+        }
     }
     else if (n == 0)
     {
         handleClose();
     }
-    else
+    else if (!(edgeTriggered && savedErrno == EWOULDBLOCK))
     {
         errno = savedErrno;
         LOG_ERROR("TcpConnection::handleRead\n");
@@ -73,29 +131,50 @@ void TcpConnection::handleWrite()
 {
     if (channel_->isWriting())
     {
+        const bool edgeTriggered = channel_->edgeTriggered();
         int savedErrno = 0;
-        ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
-        if (n > 0)
+        size_t total = 0;
+        ssize_t n = 0;
+        do
         {
-            outputBuffer_.retrieve(n);
-            if (outputBuffer_.readableBytes() == 0)
+            n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+            if (n > 0)
             {
-                channel_->disableWriting();
-                if (writeCompleteCallback_)
-                {
-                    loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
-                }
-                if (state_ == kDisconnecting)
-                {
-                    shutdownInLoop();
-                }
+                outputBuffer_.retrieve(n);
+                total += n;
+            }
+        } while (edgeTriggered && n > 0 && outputBuffer_.readableBytes() > 0 && total < kMaxBytesPerEvent);
+        loop_->metrics().addBytesWritten(total);
+        updatePendingBytes();
+
+        if (total > 0 && outputBuffer_.readableBytes() == 0)
+        {
+            channel_->disableWriting();
+            if (writeCompleteCallback_)
+            {
+                loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+            }
+            if (state_ == kDisconnecting)
+            {
+                shutdownInLoop();
             }
         }
-        else
+        else if (n > 0)
+        {
+            if (edgeTriggered)
+            {
+                loop_->queueInLoop(std::bind(&TcpConnection::resumeWrite, shared_from_this()));
+            }
+        }
+        else if (!(edgeTriggered && savedErrno == EWOULDBLOCK))
         {
             LOG_ERROR("TcpConnection::handleWrite.\n");
+            if (savedErrno == ENODATA)
+            {
+                // sendFile的文件被截断，已经无法按约定的长度发送，关闭连接
+                handleClose();
+            }
         }
-
     }
     else
     {
@@ -103,6 +182,22 @@ void TcpConnection::handleWrite()
     }
 }
 
+void TcpConnection::resumeRead(Timestamp receiveTime)
+{
+    if (state_ != kDisconnected && channel_->isReading())
+    {
+        handleRead(receiveTime);
+    }
+}
+
+void TcpConnection::resumeWrite()
+{
+    if (state_ != kDisconnected && channel_->isWriting())
+    {
+        handleWrite();
+    }
+}
+
 void TcpConnection::handleError()
 {
     int optval;
@@ -130,6 +225,11 @@ void TcpConnection::handleClose()
     closeCallback_(connPtr);  // 关闭连接的回调
 }
 
+void TcpConnection::setTcpNoDelay(bool on)
+{
+    socket_->setTcpNoDelay(on);
+}
+
 void TcpConnection::send(const std::string& buf)
 {
     if (state_ == kConnected)
@@ -140,12 +240,154 @@ void TcpConnection::send(const std::string& buf)
         }
         else
         {
-            loop_->runInLoop(std::bind(&TcpConnection::sendInLoop, this, buf.c_str(), buf.size()));
+            // 跨线程发送时拷贝一份数据，buf在回调执行前可能已经被释放
+            if (buf.size() >= BufferChain::kMinReferenceSize)
+            {
+                // 大的数据只拷贝这一次，剩余部分在outputBuffer_中按引用保存
+                send(std::make_shared<const std::string>(buf));
+            }
+            else
+            {
+                // bind成员函数指针、shared_ptr和std::string共64字节，可以内联保存在Functor中
+                void (TcpConnection::*fp)(const std::string&) = &TcpConnection::sendInLoop;
+                loop_->runInLoop(std::bind(fp, shared_from_this(), buf));
+            }
+        }
+    }
+}
+
+void TcpConnection::send(Buffer* buf)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendInLoop(buf->peek(), buf->readableBytes());
+            buf->retrieveAll();
+        }
+        else
+        {
+            send(buf->retrieveAllAsString());
+        }
+    }
+    else
+    {
+        buf->retrieveAll(); // 连接已经断开，数据丢弃，buf同样清空
+    }
+}
+
+void TcpConnection::send(std::shared_ptr<const std::string> message)
+{
+    if (state_ == kConnected)
+    {
+        if (loop_->isInLoopThread())
+        {
+            sendSharedInLoop(message);
+        }
+        else
+        {
+            loop_->runInLoop(std::bind(&TcpConnection::sendSharedInLoop, shared_from_this(), std::move(message)));
         }
     }
 }
 
-void TcpConnection::sendInLoop(const void* data, size_t len)
+void TcpConnection::sendInLoop(const std::string& message)
+{
+    sendInLoop(message.data(), message.size());
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t length)
+{
+    if (state_ != kConnected)
+    {
+        return;
+    }
+    int filefd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (filefd < 0)
+    {
+        LOG_ERROR("TcpConnection::sendFile dup fd=%d error:%d \n", fd, errno);
+        return;
+    }
+    if (loop_->isInLoopThread())
+    {
+        sendFileInLoop(filefd, offset, length);
+    }
+    else
+    {
+        loop_->runInLoop(std::bind(&TcpConnection::sendFileInLoop, shared_from_this(), filefd, offset, length));
+    }
+}
+
+void TcpConnection::sendFileInLoop(int fd, off_t offset, size_t length)
+{
+    ssize_t nwrote = 0;
+    size_t remaining = length;
+    bool faultError = false;
+    if (state_ == kDisconnected)
+    {
+        LOG_ERROR("Disconnected, giveup writing.\n");
+        ::close(fd);
+        return;
+    }
+    touch(loop_->pollReturnTime());
+
+    // 和sendInLoop一样，输出缓冲区为空时先直接发送一次
+    if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
+    {
+        off_t off = offset;
+        nwrote = ::sendfile(channel_->fd(), fd, &off, length);
+        if (nwrote >= 0)
+        {
+            loop_->metrics().addBytesWritten(nwrote);
+            remaining = length - nwrote;
+            if (remaining == 0 && writeCompleteCallback_)
+            {
+                loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+            }
+        }
+        else
+        {
+            nwrote = 0;
+            if (errno != EWOULDBLOCK)
+            {
+                LOG_ERROR("TcpConnection::sendFileInLoop\n");
+                if (errno == EPIPE || errno == ECONNRESET)
+                {
+                    faultError = true;
+                }
+            }
+        }
+    }
+
+    if (!faultError && remaining > 0)
+    {
+        size_t oldlen = outputBuffer_.readableBytes();
+        if (oldlen + remaining >= highWaterMark_ &&
+            oldlen < highWaterMark_ &&
+            hightWaterMarkCallback_)
+        {
+            loop_->queueInLoop(std::bind(hightWaterMarkCallback_, shared_from_this(), oldlen + remaining));
+        }
+        // 剩余部分在handleWrite中继续用sendfile发送，fd交给outputBuffer_管理
+        outputBuffer_.appendFile(fd, offset + nwrote, remaining);
+        updatePendingBytes();
+        if (!channel_->isWriting())
+        {
+            channel_->enableWriting();
+        }
+    }
+    else
+    {
+        ::close(fd);
+    }
+}
+
+void TcpConnection::sendSharedInLoop(const std::shared_ptr<const std::string>& message)
+{
+    sendInLoop(message->data(), message->size(), message);
+}
+
+void TcpConnection::sendInLoop(const void* data, size_t len, const std::shared_ptr<const void>& owner)
 {
     ssize_t nwrote = 0;
     ssize_t remaining = len;
@@ -156,6 +398,7 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
         LOG_ERROR("Disconnected, giveup writing.\n");
         return;
     }
+    touch(loop_->pollReturnTime());
 
     // channel第一次开始写数据，缓冲区没有待发送的数据
     if (!channel_->isWriting() && outputBuffer_.readableBytes() == 0)
@@ -163,6 +406,7 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
         nwrote = ::write(channel_->fd(), data, len);
         if (nwrote >=0 )
         {
+            loop_->metrics().addBytesWritten(nwrote);
             remaining = len - nwrote;
             if (remaining == 0 && writeCompleteCallback_)
             {
@@ -196,7 +440,16 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
         {
             loop_->queueInLoop(std::bind(hightWaterMarkCallback_, shared_from_this(), oldlen + remaining));
         }
-        outputBuffer_.append((char*)data + nwrote, remaining);
+        const char* rest = static_cast<const char*>(data) + nwrote;
+        if (owner)
+        {
+            outputBuffer_.append(owner, rest, remaining);
+        }
+        else
+        {
+            outputBuffer_.append(rest, remaining);
+        }
+        updatePendingBytes();
         if (!channel_->isWriting())
         {
             channel_->enableWriting(); // 一定要注册channel的写事件，否则Poller不会给Channel通知EPOLLOUT
@@ -204,6 +457,57 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     }
 }
 
+void TcpConnection::startRead()
+{
+    loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::startReadInLoop()
+{
+    reading_ = true;
+    if ((state_ == kConnected || state_ == kDisconnecting) && !channel_->isReading())
+    {
+        channel_->enableReading();
+        if (channel_->edgeTriggered())
+        {
+            // 暂停期间到达的数据不会再产生新的边缘，主动读一次
+            loop_->queueInLoop(std::bind(&TcpConnection::resumeRead, shared_from_this(), Timestamp::now()));
+        }
+    }
+}
+
+void TcpConnection::stopRead()
+{
+    loop_->runInLoop(std::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopReadInLoop()
+{
+    reading_ = false;
+    if ((state_ == kConnected || state_ == kDisconnecting) && channel_->isReading())
+    {
+        channel_->disableReading();
+    }
+}
+
+void TcpConnection::setBackpressure(const TcpConnectionPtr& source, size_t highWaterMark, size_t lowWaterMark)
+{
+    TcpConnectionPtr self(shared_from_this());
+    loop_->runInLoop([self, source, highWaterMark, lowWaterMark]() {
+        if (self->sourcePaused_)
+        {
+            self->resumeSource(); // 换source之前先恢复原来的
+        }
+        self->backpressureSource_ = source;
+        self->backpressureHigh_ = source ? highWaterMark : 0;
+        self->backpressureLow_ = lowWaterMark;
+        if (self->backpressureHigh_ > 0)
+        {
+            self->checkBackpressure(self->outputBuffer_.readableBytes());
+        }
+    });
+}
+
 void TcpConnection::shutdown()
 {
     if (state_ == kConnected)
@@ -221,12 +525,38 @@ void TcpConnection::shutdownInLoop()
     }
 }
 
+void TcpConnection::forceClose()
+{
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        setState(kDisconnecting);
+        loop_->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+    }
+}
+
+void TcpConnection::forceCloseInLoop()
+{
+    if (state_ == kConnected || state_ == kDisconnecting)
+    {
+        handleClose(); // 和对端关闭连接的处理相同
+    }
+}
+
 // 在创建连接时调用
 void TcpConnection::connectEstablised()
 {
     setState(kConnected);
     channel_->tie(shared_from_this());
-    channel_->enableReading();
+    if (reading_)
+    {
+        channel_->enableReading();
+    }
+
+    lastActive_ = Timestamp::now();
+    if (idleTimeout_ > 0)
+    {
+        loop_->timingWheel()->add(shared_from_this());
+    }
 
     connectionCallback_(shared_from_this());
 }
@@ -242,4 +572,53 @@ void TcpConnection::connectDestroyed()
         connectionCallback_(shared_from_this());
     }
     channel_->remove(); // 把channel从Poller中删除掉
+    if (sourcePaused_)
+    {
+        resumeSource(); // 不再有数据要发送，不能让source一直暂停
+    }
+
+    loop_->addPendingBytes(-static_cast<int64_t>(reportedPendingBytes_));
+    reportedPendingBytes_ = 0;
+    loop_->addConnections(-1);
+}
+
+void TcpConnection::updatePendingBytes()
+{
+    size_t pending = outputBuffer_.readableBytes();
+    if (pending != reportedPendingBytes_)
+    {
+        loop_->addPendingBytes(static_cast<int64_t>(pending) - static_cast<int64_t>(reportedPendingBytes_));
+        reportedPendingBytes_ = pending;
+        if (backpressureHigh_ > 0)
+        {
+            checkBackpressure(pending);
+        }
+    }
+}
+
+void TcpConnection::checkBackpressure(size_t pending)
+{
+    if (!sourcePaused_ && pending >= backpressureHigh_)
+    {
+        TcpConnectionPtr source = backpressureSource_.lock();
+        if (source)
+        {
+            source->stopRead();
+            sourcePaused_ = true;
+        }
+    }
+    else if (sourcePaused_ && pending <= backpressureLow_)
+    {
+        resumeSource();
+    }
+}
+
+void TcpConnection::resumeSource()
+{
+    sourcePaused_ = false;
+    TcpConnectionPtr source = backpressureSource_.lock();
+    if (source)
+    {
+        source->startRead();
+    }
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "InetAddress.h"
 #include "Callback.h"
 #include "Buffer.h"
+#include "BufferChain.h"
 #include "Timestamp.h"
 
 #include <memory>
@@ -37,8 +38,37 @@ public:
     bool disconnected() const { return state_ == kDisconnected; }
 
     void send(const std::string& buf);
+    // 发送buf中的全部可读数据并清空buf，连接已断开时只清空；在loop线程中调用时不经过中间的std::string
+    void send(Buffer* buf);
+    // 按引用发送，较大的数据不会被拷贝到输出缓冲区中，发送完成之前一直持有message
+    void send(std::shared_ptr<const std::string> message);
+    // 发送文件fd从offset开始的length字节，用sendfile零拷贝发送
+    // 内部会dup一份fd，调用之后可以直接关闭fd，但在写完成回调之前不要修改文件内容
+    // 待发送的文件字节同样计入高水位
+    void sendFile(int fd, off_t offset, size_t length);
+    // 开始/暂停从socket读取，可以跨线程调用；暂停期间数据留在内核的接收缓冲区中，由TCP的流量控制让对端慢下来
+    void startRead();
+    void stopRead();
+    bool isReading() const { return reading_; }
+
+    // 自动背压：本连接待发送的数据达到highWaterMark时暂停source的读取，降到lowWaterMark以下时恢复
+    // source通常是代理中配对的另一个连接（数据从source读出再写到本连接），也可以是本连接自己
+    // 本连接断开时恢复source的读取；source为空时取消
+    void setBackpressure(const TcpConnectionPtr& source, size_t highWaterMark, size_t lowWaterMark);
+
     // 关闭连接
     void shutdown();
+    // 不等待输出缓冲区发送完成，直接关闭连接
+    void forceClose();
+
+    // 关闭Nagle算法，小的消息立即发出
+    void setTcpNoDelay(bool on);
+
+    // 空闲超时时间，单位秒，<=0表示不检测空闲，需要在连接建立之前设置
+    void setIdleTimeout(double seconds) { idleTimeout_ = seconds; }
+    double idleTimeout() const { return idleTimeout_; }
+    // 最近一次收发数据的时间
+    Timestamp lastActive() const { return lastActive_; }
 
     void SetConnectionCallback(const ConnectionCallback& cb)
     { connectionCallback_ = cb; }
@@ -55,6 +85,10 @@ public:
     void setCloseCallback(const CloseCallback& cb)
     { closeCallback_ = cb; }
 
+    // 边缘触发模式，读写都一直进行到EAGAIN，开关写事件不再调用epoll_ctl
+    // 需要在连接建立之前设置
+    void setEdgeTriggered(bool on);
+
     // 连接建立
     void connectEstablised();
     // 连接销毁
@@ -62,20 +96,40 @@ public:
 
 private:
     enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
+    // 边缘触发模式下一次事件最多读写的字节数，避免一个繁忙的连接饿死同一个loop中的其他连接
+    static const size_t kMaxBytesPerEvent = 256 * 1024;
     void setState(StateE state) { state_ = state; }
     void handleRead(Timestamp receiveTiem);
     void handleWrite();
+    // 边缘触发模式下一次事件的读写量达到kMaxBytesPerEvent时，剩下的放到下一轮继续
+    void resumeRead(Timestamp receiveTime);
+    void resumeWrite();
     void handleClose();
     void handleError();
 
 
-    void sendInLoop(const void* message, size_t len);
+    // owner不为空时，未发送完的数据按引用保存在outputBuffer_中
+    void sendInLoop(const void* message, size_t len,
+                    const std::shared_ptr<const void>& owner = std::shared_ptr<const void>());
+    void sendInLoop(const std::string& message);
+    void sendSharedInLoop(const std::shared_ptr<const std::string>& message);
+    // fd是sendFile中dup出来的，由这里负责关闭
+    void sendFileInLoop(int fd, off_t offset, size_t length);
+    void startReadInLoop();
+    void stopReadInLoop();
     void shutdownInLoop();
+    void forceCloseInLoop();
+    // 把outputBuffer_的大小变化计入loop的待发送字节数，并按背压的水位暂停或恢复source的读取
+    void updatePendingBytes();
+    void checkBackpressure(size_t pending);
+    void resumeSource();
+    // 有读写时刷新活跃时间，时间轮到期时据此判断是否空闲
+    void touch(Timestamp now) { lastActive_ = now; }
 
     EventLoop* loop_; // 绝对不是baseloop， 因为TcpConnection都是在subLoop里面的
     const std::string name_;
     std::atomic_int state_;
-    bool reading_;
+    bool reading_; // 用户是否希望读取，stopRead之后为false
 
     // 和Acceptor类似 Acceptor=>mainLoop TcpConnection=>subLoop
     std::unique_ptr<Socket> socket_;
@@ -91,6 +145,15 @@ private:
     CloseCallback closeCallback_;
     size_t highWaterMark_;
 
+    double idleTimeout_;
+    Timestamp lastActive_;
+
     Buffer inputBuffer_;
-    Buffer outputBuffer_;
+    BufferChain outputBuffer_; // 分块的输出缓冲区，追加时不搬移已有数据
+    size_t reportedPendingBytes_; // 已经计入loop_->pendingBytes()的字节数
+
+    std::weak_ptr<TcpConnection> backpressureSource_; // 不持有，避免配对的两个连接互相引用
+    size_t backpressureHigh_;
+    size_t backpressureLow_;
+    bool sourcePaused_; // 已经因为背压暂停了source的读取
 };
\ No newline at end of file
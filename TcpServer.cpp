@@ -4,6 +4,7 @@
 
 #include <iostream>
 #include <strings.h>
+#include <future>
 
 using namespace std::placeholders;
 
@@ -22,19 +23,30 @@ TcpServer::TcpServer(EventLoop* loop,
                 const std::string& nameArg,
                 Option option)
                 : loop_(CheckLoopNotNULL(loop))
+                , listenAddr_(listenAddr)
                 , ipPort_(listenAddr.toIpPort())
                 , name_(nameArg)
-                , acceptor_(new Acceptor(loop, listenAddr, option == kReusePort))
+                , reusePortPerLoop_(option == kReusePortPerLoop)
+                // kReusePortPerLoop模式下的监听socket在start时为每个loop创建
+                , acceptor_(reusePortPerLoop_ ? nullptr : new Acceptor(loop, listenAddr, option == kReusePort))
                 , threadPool_(new EventLoopThreadPool(loop, nameArg))
-                , connectionCallback_()
-                , messageCallback_()
+                , connectionCallback_(defaultConnectionCallback)
+                , messageCallback_(defaultMessageCallback)
+                , idleTimeout_(0)
+                , edgeTriggered_(false)
+                , acceptBatch_(Acceptor::kDefaultAcceptBatch)
+                , callbackBudget_(0)
+                , stallTimeout_(0)
                 , nextConnId_(1)
                 , started_(0)
 {
-    // 当有新用户连接时，会执行TcpServer::newConnection回调
-    acceptor_->setNewConnectionCallback(
-        std::bind(&TcpServer::newConnection, this, _1, _2)
-    );
+    if (acceptor_)
+    {
+        // 当有新用户连接时，会执行TcpServer::newConnection回调
+        acceptor_->setNewConnectionCallback(
+            std::bind(&TcpServer::newConnection, this, _1, _2)
+        );
+    }
 }
 
 TcpServer::~TcpServer()
@@ -48,18 +60,68 @@ TcpServer::~TcpServer()
             std::bind(&TcpConnection::connectDestroyed, conn)
         );
     }
+
+    // 每个loop的连接只能在自己的线程中访问，等它们各自清理完
+    for (auto& acceptor : loopAcceptors_)
+    {
+        EventLoop* ioLoop = acceptor->loop;
+        if (ioLoop->isInLoopThread())
+        {
+            stopLoopAcceptor(acceptor.get());
+        }
+        else
+        {
+            std::promise<void> done;
+            LoopAcceptor* la = acceptor.get();
+            ioLoop->runInLoop([this, la, &done]() {
+                stopLoopAcceptor(la);
+                done.set_value();
+            });
+            done.get_future().wait();
+        }
+    }
 }
 
 // 有一个新的客户端的连接，会执行这个回调
 void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
 {
-    // 轮询算法选择一个subloop来管理channel
-    EventLoop* ioLoop = threadPool_->getNextLoop();
+    // 按负载均衡策略选择一个subloop来管理channel
+    EventLoop* ioLoop = threadPool_->getNextLoop(peerAddr);
     char buf[64] = {0};
     snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId_);
     ++nextConnId_;
     std::string connName = name_ + buf;
 
+    TcpConnectionPtr conn = createConnection(ioLoop, connName, sockfd, peerAddr);
+    connections_[connName] = conn;
+    // 设置了如何关闭连接的回调
+    conn->setCloseCallback(
+        std::bind(&TcpServer::removeConnection, this, std::placeholders::_1));
+    // 直接调用Tcp::connectEstablised
+    ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablised, conn));
+
+}
+
+// kReusePortPerLoop模式下由接受连接的loop直接处理，连接保存在这个loop自己的表中
+void TcpServer::newConnectionInLoop(LoopAcceptor* acceptor, int sockfd, const InetAddress& peerAddr)
+{
+    char buf[64] = {0};
+    snprintf(buf, sizeof buf, "-%s#%d-%d", ipPort_.c_str(), acceptor->index, acceptor->nextConnId);
+    ++acceptor->nextConnId;
+    std::string connName = name_ + buf;
+
+    TcpConnectionPtr conn = createConnection(acceptor->loop, connName, sockfd, peerAddr);
+    acceptor->connections[connName] = conn;
+    conn->setCloseCallback(
+        std::bind(&TcpServer::removeLoopConnection, this, acceptor, std::placeholders::_1));
+    conn->connectEstablised();
+}
+
+TcpConnectionPtr TcpServer::createConnection(EventLoop* ioLoop,
+                                             const std::string& connName,
+                                             int sockfd,
+                                             const InetAddress& peerAddr)
+{
     LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s",
         name_.c_str(), connName.c_str(), peerAddr.toIpPort().c_str());
     
@@ -78,17 +140,13 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
                                          sockfd,
                                          localAddr,
                                          peerAddr));
-    connections_[connName] = conn;
     // 下面的回调都是用户设置给TcpServer -》TcpConnection -> Channel -> Poller -> notify
     conn->SetConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleteCallback(writeCompleteCallback_);
-    // 设置了如何关闭连接的回调
-    conn->setCloseCallback(
-        std::bind(&TcpServer::removeConnection, this, std::placeholders::_1));
-    // 直接调用Tcp::connectEstablised
-    ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablised, conn));
-
+    conn->setIdleTimeout(idleTimeout_);
+    conn->setEdgeTriggered(edgeTriggered_);
+    return conn;
 }
 
 void TcpServer::removeConnection(const TcpConnectionPtr& conn)
@@ -104,16 +162,112 @@ void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn)
     ioLoop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
 }
 
+// 连接的closeCallback在它自己的loop中执行，这里就是acceptor->loop
+void TcpServer::removeLoopConnection(LoopAcceptor* acceptor, const TcpConnectionPtr& conn)
+{
+    LOG_INFO("TcpServer::removeLoopConnection [%s] - connection %s \n", name_.c_str(), conn->name().c_str());
+    acceptor->connections.erase(conn->name());
+    acceptor->loop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+void TcpServer::stopLoopAcceptor(LoopAcceptor* acceptor)
+{
+    acceptor->acceptor.reset();
+    for (auto& item : acceptor->connections)
+    {
+        item.second->connectDestroyed();
+    }
+    acceptor->connections.clear();
+}
+
 void TcpServer::setThreadNum(int numThreads)
 {
     threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setPollerBackend(Poller::Backend backend)
+{
+    threadPool_->setPollerBackend(backend);
+}
+
+void TcpServer::setCpuAffinity(const std::vector<int>& cpus)
+{
+    threadPool_->setCpuAffinity(cpus);
+}
+
+void TcpServer::setLoadBalancePolicy(LoadBalancer::Policy policy)
+{
+    threadPool_->setLoadBalancePolicy(policy);
+}
+
+std::vector<LoopMetrics::Snapshot> TcpServer::loopMetrics() const
+{
+    std::vector<LoopMetrics::Snapshot> result;
+    for (EventLoop* loop : threadPool_->getAllLoops())
+    {
+        result.push_back(loop->metrics().snapshot());
+    }
+    return result;
+}
+
+LoopMetrics::Snapshot TcpServer::metrics() const
+{
+    LoopMetrics::Snapshot total;
+    for (const LoopMetrics::Snapshot& s : loopMetrics())
+    {
+        total.merge(s);
+    }
+    return total;
+}
+
 void TcpServer::start()
 {
     if (started_++ == 0) // 防止TcpServer对象被启动多次
     {
         threadPool_->start(threadInitCallback_); // 启动底层的loop线程池
-        loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        std::vector<EventLoop*> allLoops = threadPool_->getAllLoops();
+        if (allLoops[0] != loop_)
+        {
+            allLoops.push_back(loop_);
+        }
+        if (callbackBudget_ > 0)
+        {
+            for (EventLoop* loop : allLoops)
+            {
+                loop->setCallbackBudget(callbackBudget_);
+            }
+        }
+        if (stallTimeout_ > 0)
+        {
+            watchdog_.reset(new LoopWatchdog(stallTimeout_));
+            for (EventLoop* loop : allLoops)
+            {
+                watchdog_->watch(loop);
+            }
+            watchdog_->start();
+        }
+        if (reusePortPerLoop_)
+        {
+            // 没有subloop时只有baseloop一个监听socket
+            std::vector<EventLoop*> loops = threadPool_->getAllLoops();
+            for (size_t i = 0; i < loops.size(); ++i)
+            {
+                std::unique_ptr<LoopAcceptor> acceptor(new LoopAcceptor);
+                acceptor->loop = loops[i];
+                acceptor->index = static_cast<int>(i);
+                acceptor->nextConnId = 1;
+                acceptor->acceptor.reset(new Acceptor(loops[i], listenAddr_, true));
+                acceptor->acceptor->setAcceptBatch(acceptBatch_);
+                acceptor->acceptor->setNewConnectionCallback(
+                    std::bind(&TcpServer::newConnectionInLoop, this, acceptor.get(), _1, _2));
+                loops[i]->runInLoop(std::bind(&Acceptor::listen, acceptor->acceptor.get()));
+                loopAcceptors_.push_back(std::move(acceptor));
+            }
+        }
+        else
+        {
+            acceptor_->setAcceptBatch(acceptBatch_);
+            loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        }
     }
 }
@@ -8,12 +8,14 @@
 #include "Callback.h"
 #include "TcpConnection.h"
 #include "Buffer.h"
+#include "LoopWatchdog.h"
 
 #include <functional>
 #include <string>
 #include <memory>
 #include <atomic>
 #include <unordered_map>
+#include <vector>
 
 class TcpServer : noncopyable 
 {
@@ -24,6 +26,9 @@ public:
     {
         kNoReusePort,
         kReusePort,
+        // 每个loop线程各自持有一个SO_REUSEPORT的监听socket，由内核分发新连接，
+        // 连接在接受它的loop中注册和处理，不需要跨线程转交
+        kReusePortPerLoop,
     };
 
     TcpServer(EventLoop* loop,
@@ -32,28 +37,78 @@ public:
             Option option = kNoReusePort);
     ~TcpServer();
 
+    const std::string& name() const { return name_; }
+    const std::string& ipPort() const { return ipPort_; }
+
     // 设置底层subloop的个数
     void setThreadNum(int numThreads);
     void setThreadInitCallback(const ThreadInitCallback& cb) { threadInitCallback_ = cb; }
     void setConnectionCallback(const ConnectionCallback& cb) { connectionCallback_ = cb; }
     void setMessageCallback(const MessageCallback& cb) { messageCallback_ = cb; }
     void setWriteCompeleteCallback(const WriteCompleteCallback& cb) { writeCompleteCallback_ = cb; }
+    // 连接空闲超过seconds秒没有收发数据就强制关闭，0表示不检测，需要在start之前设置
+    void setIdleTimeout(int seconds) { idleTimeout_ = seconds; }
+    // subloop使用的IO复用实现（epoll或者io_uring），需要在start之前设置
+    // baseloop由用户创建，可以在构造EventLoop时指定
+    void setPollerBackend(Poller::Backend backend);
+    // 新连接使用边缘触发模式，需要在start之前设置
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+    // subloop依次绑定到cpus中的CPU上，需要在start之前设置
+    void setCpuAffinity(const std::vector<int>& cpus);
+    // 新连接分配给subloop的策略，默认轮询，需要在start之前设置；kReusePortPerLoop模式下由内核分配
+    void setLoadBalancePolicy(LoadBalancer::Policy policy);
+    // 监听socket每次可读事件最多accept的连接数，需要在start之前设置
+    void setAcceptBatch(int n) { acceptBatch_ = n; }
+
+    // loop线程池，可以把TcpClient的连接也放在这些loop上，start之后才能取到subloop
+    std::shared_ptr<EventLoopThreadPool> threadPool() const { return threadPool_; }
+
+    // 所有loop中单个回调超过seconds秒时记录日志，0表示不检查，需要在start之前设置
+    void setCallbackBudget(double seconds) { callbackBudget_ = seconds; }
+    // 启动看门狗线程，任何loop一轮超过seconds秒没有结束时报告卡住的回调，0表示不启动，需要在start之前设置
+    void setStallTimeout(double seconds) { stallTimeout_ = seconds; }
+
+    // 所有loop（没有subloop时就是baseloop）的运行统计，不需要停下loop，可以在任意线程调用
+    std::vector<LoopMetrics::Snapshot> loopMetrics() const;
+    // loopMetrics()累加之后的结果
+    LoopMetrics::Snapshot metrics() const;
 
     // 开启服务器监听
     void start();
 private:
+    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+
+    // kReusePortPerLoop模式下一个loop的监听socket和连接，只在这个loop线程中访问
+    struct LoopAcceptor
+    {
+        EventLoop* loop;
+        int index;
+        int nextConnId;
+        std::unique_ptr<Acceptor> acceptor;
+        ConnectionMap connections;
+    };
+
     void newConnection(int sockfd, const InetAddress& peerAddr);
     void removeConnection(const TcpConnectionPtr& conn);
     void removeConnectionInLoop(const TcpConnectionPtr& conn);
 
-    using ConnectionMap = std::unordered_map<std::string, TcpConnectionPtr>;
+    void newConnectionInLoop(LoopAcceptor* acceptor, int sockfd, const InetAddress& peerAddr);
+    void removeLoopConnection(LoopAcceptor* acceptor, const TcpConnectionPtr& conn);
+    // 关闭监听socket并销毁这个loop上的所有连接，在acceptor->loop中执行
+    void stopLoopAcceptor(LoopAcceptor* acceptor);
+
+    // 创建连接并设置用户的回调，closeCallback由调用者设置
+    TcpConnectionPtr createConnection(EventLoop* ioLoop, const std::string& connName,
+                                      int sockfd, const InetAddress& peerAddr);
 
     EventLoop* loop_;
 
+    const InetAddress listenAddr_;
     const std::string ipPort_;
     const std::string name_;
+    const bool reusePortPerLoop_;
 
-    std::unique_ptr<Acceptor> acceptor_; // 运行在mainLoop中，监听新连接的事件
+    std::unique_ptr<Acceptor> acceptor_; // 运行在mainLoop中，监听新连接的事件，kReusePortPerLoop模式下为空
 
     std::shared_ptr<EventLoopThreadPool> threadPool_;
 
@@ -62,8 +117,16 @@ private:
     WriteCompleteCallback writeCompleteCallback_; // 消息写完后的回调
     ThreadInitCallback threadInitCallback_; // loop线程初始化的回调
 
+    int idleTimeout_; // 空闲连接超时时间，单位秒
+    bool edgeTriggered_; // 连接是否使用边缘触发模式
+    int acceptBatch_; // 每次可读事件最多accept的连接数
+    double callbackBudget_; // 单个回调的耗时预算，单位秒
+    double stallTimeout_; // 看门狗的卡顿阈值，单位秒
+
     std::atomic_int started_;
     int nextConnId_;
     ConnectionMap connections_; // 保存所有的连接
+    std::vector<std::unique_ptr<LoopAcceptor>> loopAcceptors_; // kReusePortPerLoop模式下每个loop一个，连接保存在各自的loop中
+    std::unique_ptr<LoopWatchdog> watchdog_; // 在threadPool_之前析构，先停止看门狗再退出loop
 
 };
\ No newline at end of file
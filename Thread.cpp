@@ -1,7 +1,11 @@
 #include "Thread.h"
 #include "CurrentThread.h"
+#include "Logger.h"
 
+#include <errno.h>
 #include <semaphore.h>
+#include <pthread.h>
+#include <sched.h>
 
 std::atomic_int32_t Thread::numCreated_(0);
 
@@ -32,6 +36,7 @@ void Thread::start()
     // 开启线程
     thread_ = std::shared_ptr<std::thread>(new std::thread([&](){
         tid_ = CurrentThread::tid(); // 获取线程tid值
+        initOsThread();
         sem_post(&sem);
         func_(); // 开启一个新线程，专门执行该线程函数
     }));
@@ -45,6 +50,27 @@ void Thread::join()
     thread_->join();
 }
 
+// 在新线程中执行，绑核要在func_申请内存之前，线程的内存才会分配在所在CPU的NUMA节点上
+void Thread::initOsThread()
+{
+    // 内核限制线程名最多15个字符
+    ::pthread_setname_np(::pthread_self(), name_.substr(0, 15).c_str());
+
+    if (!cpus_.empty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus_)
+        {
+            CPU_SET(cpu, &set);
+        }
+        if (::sched_setaffinity(0, sizeof set, &set) < 0)
+        {
+            LOG_ERROR("%s:%s:%d thread %s sched_setaffinity error:%d \n", __FILE__, __FUNCTION__, __LINE__, name_.c_str(), errno);
+        }
+    }
+}
+
 void Thread::setDefaultName()
 {
     int num = ++numCreated_;
@@ -6,6 +6,7 @@
 #include <unistd.h>
 #include <string>
 #include <atomic>
+#include <vector>
 
 #include "noncopyable.h"
 
@@ -17,17 +18,23 @@ public:
     explicit Thread(ThreadFunc, const std::string& name = std::string());
     ~Thread();
 
+    // 线程启动时绑定到cpus中的CPU上，为空表示不绑定，需要在start之前设置
+    void setCpuAffinity(const std::vector<int>& cpus) { cpus_ = cpus; }
+
+    // 启动线程，新线程先设置名字（top、perf中可见）和CPU亲和性再执行func
     void start();
     void join();
 
     bool started() const { return started_; }
     pid_t pid() const { return tid_; }
     const std::string& name() { return name_; }
+    const std::vector<int>& cpuAffinity() const { return cpus_; }
     
     static int numCreated() { return numCreated_; }
 
 private:
     void setDefaultName();
+    void initOsThread();
 
     bool started_;
     bool joined_;
@@ -35,5 +42,6 @@ private:
     pid_t tid_;
     ThreadFunc func_;
     std::string name_;
+    std::vector<int> cpus_;
     static std::atomic_int32_t numCreated_;
 };
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+class Timer;
+
+/**
+ * 用户持有的定时器句柄，只用于EventLoop::cancel
+ * 同时保存Timer的地址和序号，避免地址被新Timer复用时误删
+*/
+class TimerId
+{
+public:
+    TimerId()
+        : timer_(nullptr)
+        , sequence_(0)
+    {
+    }
+
+    TimerId(Timer* timer, int64_t seq)
+        : timer_(timer)
+        , sequence_(seq)
+    {
+    }
+
+    friend class TimerQueue;
+
+private:
+    Timer* timer_;
+    int64_t sequence_;
+};
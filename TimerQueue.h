@@ -0,0 +1,58 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Timestamp.h"
+#include "Callback.h"
+#include "Channel.h"
+
+#include <set>
+#include <vector>
+#include <utility>
+
+class EventLoop;
+class Timer;
+class TimerId;
+
+/**
+ * 每个EventLoop持有一个TimerQueue，所有定时器共用一个timerfd
+ * timerfd作为一个普通的Channel注册到Poller上，到期后在loop线程中执行回调
+ * 定时器按到期时间保存在有序集合中，timerfd总是设置为最早的到期时间
+*/
+class TimerQueue : noncopyable
+{
+public:
+    explicit TimerQueue(EventLoop* loop);
+    ~TimerQueue();
+
+    // 线程安全，可以在其他线程中调用
+    TimerId addTimer(TimerCallback cb, Timestamp when, double interval);
+    void cancel(TimerId timerId);
+
+private:
+    using Entry = std::pair<Timestamp, Timer*>;
+    using TimerList = std::set<Entry>;
+    using ActiveTimer = std::pair<Timer*, int64_t>;
+    using ActiveTimerSet = std::set<ActiveTimer>;
+
+    void addTimerInLoop(Timer* timer);
+    void cancelInLoop(TimerId timerId);
+    // timerfd可读时的回调
+    void handleRead();
+    // 取出所有到期的定时器
+    std::vector<Entry> getExpired(Timestamp now);
+    // 重新插入重复的定时器，并重置timerfd
+    void reset(const std::vector<Entry>& expired, Timestamp now);
+    // 返回最早到期的时间是否发生了变化
+    bool insert(Timer* timer);
+
+    EventLoop* loop_;
+    const int timerfd_;
+    Channel timerfdChannel_;
+    TimerList timers_; // 按到期时间排序
+
+    // 与timers_保存相同的定时器，按地址排序，用于cancel
+    ActiveTimerSet activeTimers_;
+    bool callingExpiredTimers_;
+    // 在执行到期回调时被取消的定时器，不再重新插入
+    ActiveTimerSet cancelingTimers_;
+};
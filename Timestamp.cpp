@@ -1,29 +1,145 @@
 #include "Timestamp.h"
 
 #include <time.h>
+#include <string.h>
+#include <sys/time.h>
+
+// 每个线程缓存最近一次格式化的秒 "2024/04/23 02:45:45"
+// localtime会加全局锁并读取TZ，秒数不变时就不再调用
+static __thread time_t t_lastSecond = -1;
+static __thread char t_time[Timestamp::kFormattedSize];
+static __thread size_t t_timeLen = 0;
+
+static inline void write2(char* p, int v)
+{
+    p[0] = static_cast<char>('0' + v / 10);
+    p[1] = static_cast<char>('0' + v % 10);
+}
+
+static inline void write4(char* p, int v)
+{
+    write2(p, v / 100);
+    write2(p + 2, v % 100);
+}
+
+static inline void writeMicroseconds(char* p, int v)
+{
+    for (int i = 5; i >= 0; --i)
+    {
+        p[i] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    }
+}
+
+// 把从1970-01-01开始的天数转换为公历日期，参考 Howard Hinnant 的 civil_from_days
+static void civilFromDays(int64_t z, int* year, int* month, int* day)
+{
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    *day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    *month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    *year = static_cast<int>(static_cast<int64_t>(yoe) + era * 400 + (*month <= 2));
+}
 
 Timestamp::Timestamp() : microSecondsSinceEpoch_(0) {
 }
 
-Timestamp::Timestamp(int64_t microSecondsSinceEpoch) 
+Timestamp::Timestamp(int64_t microSecondsSinceEpoch)
     : microSecondsSinceEpoch_(microSecondsSinceEpoch) {
 }
 
 Timestamp Timestamp::now() {
-    return Timestamp(time(NULL));
+    timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t seconds = tv.tv_sec;
+    return Timestamp(seconds * kMicroSecondsPerSecond + tv.tv_usec);
+}
+
+size_t Timestamp::formatTo(char* buf, bool showMicroseconds) const {
+    time_t seconds = secondsSinceEpoch();
+    if (seconds != t_lastSecond)
+    {
+        t_lastSecond = seconds;
+        tm tm_time;
+        localtime_r(&seconds, &tm_time);
+        char* p = t_time;
+        write4(p, tm_time.tm_year + 1900);
+        p[4] = '/';
+        write2(p + 5, tm_time.tm_mon + 1);
+        p[7] = '/';
+        write2(p + 8, tm_time.tm_mday);
+        p[10] = ' ';
+        write2(p + 11, tm_time.tm_hour);
+        p[13] = ':';
+        write2(p + 14, tm_time.tm_min);
+        p[16] = ':';
+        write2(p + 17, tm_time.tm_sec);
+        t_timeLen = 19;
+    }
+
+    memcpy(buf, t_time, t_timeLen);
+    size_t len = t_timeLen;
+    if (showMicroseconds)
+    {
+        buf[len] = '.';
+        writeMicroseconds(buf + len + 1,
+            static_cast<int>(microSecondsSinceEpoch_ % kMicroSecondsPerSecond));
+        len += 7;
+    }
+    buf[len] = '\0';
+    return len;
 }
 
 std::string Timestamp::toString() const {
-    char buf[128] = {0};
-    tm* tm_time = localtime(&microSecondsSinceEpoch_);
-    snprintf(buf, 128, "%4d/%02d/%02d %02d:%02d:%02d",
-        tm_time->tm_year + 1900,
-        tm_time->tm_mon+1,
-        tm_time->tm_mday,
-        tm_time->tm_hour,
-        tm_time->tm_min,
-        tm_time->tm_sec);
-    return buf;
+    return toFormattedString(false);
+}
+
+std::string Timestamp::toFormattedString(bool showMicroseconds) const {
+    char buf[kFormattedSize];
+    size_t len = formatTo(buf, showMicroseconds);
+    return std::string(buf, len);
+}
+
+std::string Timestamp::toIso8601() const {
+    int64_t seconds = microSecondsSinceEpoch_ / kMicroSecondsPerSecond;
+    int microseconds = static_cast<int>(microSecondsSinceEpoch_ % kMicroSecondsPerSecond);
+    int64_t days = seconds / 86400;
+    int secondsOfDay = static_cast<int>(seconds % 86400);
+    if (microseconds < 0)
+    {
+        microseconds += kMicroSecondsPerSecond;
+        --secondsOfDay;
+    }
+    if (secondsOfDay < 0)
+    {
+        secondsOfDay += 86400;
+        --days;
+    }
+
+    int year, month, day;
+    civilFromDays(days, &year, &month, &day);
+
+    // 2024-04-23T02:45:45.123456Z
+    char buf[kFormattedSize];
+    write4(buf, year);
+    buf[4] = '-';
+    write2(buf + 5, month);
+    buf[7] = '-';
+    write2(buf + 8, day);
+    buf[10] = 'T';
+    write2(buf + 11, secondsOfDay / 3600);
+    buf[13] = ':';
+    write2(buf + 14, secondsOfDay / 60 % 60);
+    buf[16] = ':';
+    write2(buf + 17, secondsOfDay % 60);
+    buf[19] = '.';
+    writeMicroseconds(buf + 20, microseconds);
+    buf[26] = 'Z';
+    return std::string(buf, 27);
 }
 
 // #include <iostream>
@@ -31,4 +147,4 @@ std::string Timestamp::toString() const {
 // int main() {
 //     std::cout << Timestamp::now().toString() << std::endl;
 //     return 0;
-// }
\ No newline at end of file
+// }
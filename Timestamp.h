@@ -2,15 +2,59 @@
 
 #include <cstdint>
 #include <string>
+#include <ctime>
 
+// 微秒精度的时间戳，定时器以它作为到期时间的key
 class Timestamp {
 public:
     Timestamp();
     explicit Timestamp(int64_t microSeoncdsSinceEpoch);
 
     static Timestamp now();
+    static Timestamp invalid() { return Timestamp(); }
+
+    // 本地时间 "2024/04/23 02:45:45"
     std::string toString() const;
+    // 本地时间，showMicroseconds为true时追加 ".123456"
+    std::string toFormattedString(bool showMicroseconds = true) const;
+    // UTC时间，ISO-8601格式 "2024-04-23T02:45:45.123456Z"，不经过libc的时区处理
+    std::string toIso8601() const;
+    // 把本地时间格式化到buf中，buf至少kFormattedSize字节，不分配内存，返回写入的长度
+    // 每个线程缓存上一次格式化的秒，同一秒内只需要追加微秒部分
+    size_t formatTo(char* buf, bool showMicroseconds) const;
+    static const size_t kFormattedSize = 32;
+
+    bool valid() const { return microSecondsSinceEpoch_ > 0; }
+    int64_t microSecondsSinceEpoch() const { return microSecondsSinceEpoch_; }
+    time_t secondsSinceEpoch() const
+    { return static_cast<time_t>(microSecondsSinceEpoch_ / kMicroSecondsPerSecond); }
+
+    static const int kMicroSecondsPerSecond = 1000 * 1000;
 
 private:
     int64_t microSecondsSinceEpoch_;
-};
\ No newline at end of file
+};
+
+inline bool operator<(Timestamp lhs, Timestamp rhs)
+{
+    return lhs.microSecondsSinceEpoch() < rhs.microSecondsSinceEpoch();
+}
+
+inline bool operator==(Timestamp lhs, Timestamp rhs)
+{
+    return lhs.microSecondsSinceEpoch() == rhs.microSecondsSinceEpoch();
+}
+
+// 两个时间点的差值，单位秒
+inline double timeDifference(Timestamp high, Timestamp low)
+{
+    int64_t diff = high.microSecondsSinceEpoch() - low.microSecondsSinceEpoch();
+    return static_cast<double>(diff) / Timestamp::kMicroSecondsPerSecond;
+}
+
+// 在timestamp的基础上增加seconds秒
+inline Timestamp addTime(Timestamp timestamp, double seconds)
+{
+    int64_t delta = static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond);
+    return Timestamp(timestamp.microSecondsSinceEpoch() + delta);
+}
\ No newline at end of file
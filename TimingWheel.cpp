@@ -0,0 +1,113 @@
+#include "TimingWheel.h"
+#include "EventLoop.h"
+#include "TcpConnection.h"
+#include "Logger.h"
+
+#include <cmath>
+
+const double TimingWheel::kTickSeconds = 1.0;
+
+TimingWheel::TimingWheel(EventLoop* loop)
+    : loop_(loop)
+    , now_(0)
+    , size_(0)
+    , running_(false)
+{
+}
+
+TimingWheel::~TimingWheel() = default;
+
+void TimingWheel::add(const TcpConnectionPtr& conn)
+{
+    if (!running_)
+    {
+        // 时间轮为空时定时器是停止的，重新开始计时
+        running_ = true;
+        tickTime_ = Timestamp::now();
+        timerId_ = loop_->runEvery(kTickSeconds, std::bind(&TimingWheel::onTick, this));
+    }
+    Entry entry;
+    entry.conn = conn;
+    entry.expire = tickOf(addTime(conn->lastActive(), conn->idleTimeout()));
+    insert(std::move(entry));
+    ++size_;
+}
+
+void TimingWheel::onTick()
+{
+    ++now_;
+    tickTime_ = Timestamp::now();
+
+    // 低层转满一圈时，把高层对应槽位中的定时项下放
+    for (int level = 1; level < kLevels; ++level)
+    {
+        if ((now_ & ((int64_t(1) << (kSlotBits * level)) - 1)) != 0)
+        {
+            break;
+        }
+        cascade(level, static_cast<int>((now_ >> (kSlotBits * level)) & kSlotMask));
+    }
+
+    Bucket expired;
+    expired.swap(buckets_[0][now_ & kSlotMask]);
+    for (Entry& entry : expired)
+    {
+        TcpConnectionPtr conn = entry.conn.lock();
+        if (!conn || conn->disconnected())
+        {
+            --size_;
+            continue;
+        }
+        // 期间有过读写，按最新的活跃时间重新插入
+        Timestamp deadline = addTime(conn->lastActive(), conn->idleTimeout());
+        if (tickTime_ < deadline)
+        {
+            entry.expire = tickOf(deadline);
+            insert(std::move(entry));
+            continue;
+        }
+        --size_;
+        LOG_INFO("TimingWheel: connection [%s] idle timeout \n", conn->name().c_str());
+        conn->forceClose();
+    }
+
+    if (size_ == 0)
+    {
+        running_ = false;
+        loop_->cancel(timerId_);
+    }
+}
+
+void TimingWheel::cascade(int level, int slot)
+{
+    Bucket entries;
+    entries.swap(buckets_[level][slot]);
+    for (Entry& entry : entries)
+    {
+        insert(std::move(entry));
+    }
+}
+
+void TimingWheel::insert(Entry entry)
+{
+    int64_t delta = entry.expire - now_;
+    for (int level = 0; level < kLevels; ++level)
+    {
+        if (delta < (int64_t(1) << (kSlotBits * (level + 1))))
+        {
+            int slot = static_cast<int>((entry.expire >> (kSlotBits * level)) & kSlotMask);
+            buckets_[level][slot].push_back(std::move(entry));
+            return;
+        }
+    }
+    // 超出时间轮能表示的范围，先放在最远的位置，到期时会重新计算
+    entry.expire = now_ + (int64_t(1) << (kSlotBits * kLevels)) - 1;
+    insert(std::move(entry));
+}
+
+int64_t TimingWheel::tickOf(Timestamp deadline) const
+{
+    double delta = std::ceil(timeDifference(deadline, tickTime_) / kTickSeconds);
+    int64_t ticks = delta < 1.0 ? 1 : static_cast<int64_t>(delta);
+    return now_ + ticks;
+}
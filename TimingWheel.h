@@ -0,0 +1,59 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Timestamp.h"
+#include "TimerId.h"
+#include "Callback.h"
+
+#include <vector>
+#include <memory>
+
+class EventLoop;
+
+/**
+ * 分层时间轮，每个EventLoop一个，用于踢掉空闲连接
+ * 每层kSlots个槽，第0层每个槽为1个tick(1秒)，第n层每个槽覆盖kSlots^n个tick
+ * 槽里只保存weak_ptr<TcpConnection>，连接有读写时只更新自己的lastActive时间戳，
+ * 不移动槽位；到期时再根据lastActive判断是真正超时，还是重新插入到新的槽里
+ * 因此收发数据时的touch是O(1)的一次赋值，插入和到期处理也都是O(1)
+*/
+class TimingWheel : noncopyable
+{
+public:
+    explicit TimingWheel(EventLoop* loop);
+    ~TimingWheel();
+
+    // 必须在loop线程中调用，超时时间取conn->idleTimeout()
+    void add(const TcpConnectionPtr& conn);
+
+    size_t size() const { return size_; }
+
+private:
+    static const int kSlotBits = 6;
+    static const int kSlots = 1 << kSlotBits;
+    static const int kSlotMask = kSlots - 1;
+    static const int kLevels = 4; // 最多可以表示 64^4 秒
+    static const double kTickSeconds;
+
+    struct Entry
+    {
+        std::weak_ptr<TcpConnection> conn;
+        int64_t expire; // 到期的tick
+    };
+    using Bucket = std::vector<Entry>;
+
+    void onTick();
+    // 把第level层的slot槽位中的定时项重新放入下层
+    void cascade(int level, int slot);
+    void insert(Entry entry);
+    // 到期时间deadline对应的tick，至少是下一个tick
+    int64_t tickOf(Timestamp deadline) const;
+
+    EventLoop* loop_;
+    Bucket buckets_[kLevels][kSlots];
+    int64_t now_; // 当前tick
+    Timestamp tickTime_; // 当前tick开始的时间
+    size_t size_; // 时间轮中定时项的个数
+    bool running_; // 没有定时项时停止定时器，空闲的loop不会被唤醒
+    TimerId timerId_;
+};
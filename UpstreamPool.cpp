@@ -0,0 +1,501 @@
+#include "UpstreamPool.h"
+#include "Connector.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TcpConnection.h"
+
+#include <algorithm>
+#include <deque>
+#include <errno.h>
+#include <future>
+#include <stdio.h>
+#include <strings.h>
+#include <sys/socket.h>
+
+using namespace std::placeholders;
+
+namespace
+{
+
+uint64_t addressKey(const InetAddress& addr)
+{
+    const sockaddr_in* sa = addr.getSockAddr();
+    return (static_cast<uint64_t>(sa->sin_addr.s_addr) << 16) | sa->sin_port;
+}
+
+// 只有loop线程写的计数器
+void increase(std::atomic<uint64_t>& counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// 连接池析构之后连接才关闭时使用
+void destroyConnection(const TcpConnectionPtr& conn)
+{
+    conn->getLoop()->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+} // namespace
+
+// 一个loop上到一个后端的连接
+// 不在idle中的连接都计入busy，包括借出的和正在关闭的，closeCallback执行时减去
+struct UpstreamPool::Upstream
+{
+    struct Waiter
+    {
+        CheckoutCallback cb;
+        uint64_t start; // checkout的时间，纳秒
+    };
+
+    struct IdleConnection
+    {
+        TcpConnectionPtr conn;
+        uint64_t since; // 放回空闲列表的时间，纳秒
+    };
+
+    explicit Upstream(const InetAddress& addr)
+        : addr(addr)
+        , busy(0)
+    {
+    }
+
+    size_t total() const { return idle.size() + busy + connectors.size(); }
+
+    InetAddress addr;
+    std::deque<IdleConnection> idle; // 末尾是最近放回的，优先借出
+    std::deque<Waiter> waiters;
+    std::vector<ConnectorPtr> connectors; // 正在建立的连接
+    size_t busy;
+};
+
+// 一个loop的连接池，只在这个loop线程中访问；统计由loop线程写，其他线程可以读
+struct UpstreamPool::LoopPool
+{
+    explicit LoopPool(EventLoop* loop)
+        : loop(loop)
+        , sweeping(false)
+        , checkouts(0)
+        , hits(0)
+        , timeouts(0)
+        , connects(0)
+        , connectErrors(0)
+        , evictions(0)
+    {
+    }
+
+    EventLoop* loop;
+    std::unordered_map<uint64_t, std::unique_ptr<Upstream>> upstreams;
+    std::unordered_map<TcpConnectionPtr, Upstream*> owners; // 池中所有的连接，借出的也由池持有
+    bool sweeping;
+    TimerId sweepTimer;
+
+    std::atomic<uint64_t> checkouts;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> timeouts;
+    std::atomic<uint64_t> connects;
+    std::atomic<uint64_t> connectErrors;
+    std::atomic<uint64_t> evictions;
+    Histogram checkoutLatency;
+};
+
+UpstreamPool::Stats::Stats()
+    : checkouts(0)
+    , hits(0)
+    , timeouts(0)
+    , connects(0)
+    , connectErrors(0)
+    , evictions(0)
+{
+}
+
+void UpstreamPool::Stats::merge(const Stats& other)
+{
+    checkouts += other.checkouts;
+    hits += other.hits;
+    timeouts += other.timeouts;
+    connects += other.connects;
+    connectErrors += other.connectErrors;
+    evictions += other.evictions;
+    checkoutLatency.merge(other.checkoutLatency);
+}
+
+UpstreamPool::UpstreamPool(const std::vector<EventLoop*>& loops, const std::string& name)
+    : name_(name)
+    , maxIdle_(8)
+    , maxConnections_(64)
+    , idleTimeout_(60.0)
+    , checkoutTimeout_(1.0)
+    , nextConnId_(1)
+{
+    for (EventLoop* loop : loops)
+    {
+        pools_[loop].reset(new LoopPool(loop));
+    }
+}
+
+UpstreamPool::~UpstreamPool()
+{
+    for (auto& item : pools_)
+    {
+        LoopPool* pool = item.second.get();
+        if (pool->loop->isInLoopThread())
+        {
+            shutdown(pool);
+        }
+        else
+        {
+            std::promise<void> done;
+            pool->loop->runInLoop([this, pool, &done]() {
+                shutdown(pool);
+                done.set_value();
+            });
+            done.get_future().wait();
+        }
+    }
+}
+
+UpstreamPool::LoopPool* UpstreamPool::poolOf(EventLoop* loop) const
+{
+    auto it = pools_.find(loop);
+    if (it == pools_.end())
+    {
+        LOG_FATAL("%s:%s:%d UpstreamPool[%s] unknown loop %p \n", __FILE__, __FUNCTION__, __LINE__, name_.c_str(), loop);
+    }
+    return it->second.get();
+}
+
+void UpstreamPool::checkout(EventLoop* loop, const InetAddress& addr, const CheckoutCallback& cb)
+{
+    LoopPool* pool = poolOf(loop);
+    uint64_t start = LoopMetrics::nowNanos();
+    increase(pool->checkouts);
+
+    std::unique_ptr<Upstream>& slot = pool->upstreams[addressKey(addr)];
+    if (!slot)
+    {
+        slot.reset(new Upstream(addr));
+    }
+    Upstream* up = slot.get();
+    while (!up->idle.empty())
+    {
+        TcpConnectionPtr conn = std::move(up->idle.back().conn);
+        up->idle.pop_back();
+        ++up->busy;
+        if (conn->connected())
+        {
+            increase(pool->hits);
+            pool->checkoutLatency.record(LoopMetrics::nowNanos() - start);
+            cb(conn);
+            return;
+        }
+        // 正在关闭，closeCallback中从busy减去
+    }
+
+    up->waiters.push_back(Upstream::Waiter{ cb, start });
+    startSweep(pool);
+    if (up->connectors.size() < up->waiters.size() && up->total() < maxConnections_)
+    {
+        startConnect(pool, up);
+    }
+}
+
+void UpstreamPool::release(const TcpConnectionPtr& conn, bool reusable)
+{
+    if (!conn->connected())
+    {
+        return; // 已经关闭或者正在关闭，closeCallback中处理
+    }
+    LoopPool* pool = poolOf(conn->getLoop());
+    auto it = pool->owners.find(conn);
+    if (it == pool->owners.end())
+    {
+        LOG_ERROR("UpstreamPool[%s]::release - %s is not from this pool \n", name_.c_str(), conn->name().c_str());
+        return;
+    }
+    if (reusable)
+    {
+        giveBack(pool, it->second, conn);
+    }
+    else
+    {
+        evict(pool, conn);
+    }
+}
+
+UpstreamPool::Stats UpstreamPool::stats() const
+{
+    Stats result;
+    for (const auto& item : pools_)
+    {
+        const LoopPool* pool = item.second.get();
+        Stats s;
+        s.checkouts = pool->checkouts.load(std::memory_order_relaxed);
+        s.hits = pool->hits.load(std::memory_order_relaxed);
+        s.timeouts = pool->timeouts.load(std::memory_order_relaxed);
+        s.connects = pool->connects.load(std::memory_order_relaxed);
+        s.connectErrors = pool->connectErrors.load(std::memory_order_relaxed);
+        s.evictions = pool->evictions.load(std::memory_order_relaxed);
+        s.checkoutLatency = pool->checkoutLatency.snapshot();
+        result.merge(s);
+    }
+    return result;
+}
+
+void UpstreamPool::startConnect(LoopPool* pool, Upstream* up)
+{
+    ConnectorPtr connector(new Connector(pool->loop, up->addr));
+    connector->setNewConnectionCallback(
+        std::bind(&UpstreamPool::newConnection, this, pool, up, connector.get(), _1));
+    connector->setErrorCallback(
+        std::bind(&UpstreamPool::connectError, this, pool, up, connector.get(), _1));
+    up->connectors.push_back(connector);
+    connector->start();
+}
+
+void UpstreamPool::removeConnector(Upstream* up, Connector* connector)
+{
+    for (auto it = up->connectors.begin(); it != up->connectors.end(); ++it)
+    {
+        if (it->get() == connector)
+        {
+            up->connectors.erase(it); // Connector排队的resetChannel或者正在执行的回调还持有它
+            break;
+        }
+    }
+}
+
+void UpstreamPool::newConnection(LoopPool* pool, Upstream* up, Connector* connector, int sockfd)
+{
+    removeConnector(up, connector);
+
+    sockaddr_in peer;
+    sockaddr_in local;
+    socklen_t len = sizeof peer;
+    bzero(&peer, sizeof peer);
+    bzero(&local, sizeof local);
+    if (::getpeername(sockfd, (sockaddr*)&peer, &len) < 0)
+    {
+        LOG_ERROR("UpstreamPool::newConnection getpeername error %d \n", errno);
+    }
+    len = sizeof local;
+    if (::getsockname(sockfd, (sockaddr*)&local, &len) < 0)
+    {
+        LOG_ERROR("UpstreamPool::newConnection getsockname error %d \n", errno);
+    }
+    InetAddress peerAddr(peer);
+    InetAddress localAddr(local);
+
+    char buf[64] = {0};
+    snprintf(buf, sizeof buf, ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_++);
+    std::string connName = name_ + buf;
+
+    TcpConnectionPtr conn(new TcpConnection(pool->loop, connName, sockfd, localAddr, peerAddr));
+    conn->SetConnectionCallback(defaultConnectionCallback);
+    conn->setMessageCallback(std::bind(&UpstreamPool::idleMessage, this, pool, _1, _2, _3));
+    conn->setCloseCallback(std::bind(&UpstreamPool::removeConnection, this, pool, _1));
+    pool->owners[conn] = up;
+    ++up->busy;
+    increase(pool->connects);
+    conn->connectEstablised();
+    giveBack(pool, up, conn);
+}
+
+// Connector已经放弃，不在这里重新连接，免得错误一直存在时反复connect
+// 还有正在建立的连接或者借出的连接时，它们会交给等待者；都没有时等待者只能等到超时，直接回调nullptr
+void UpstreamPool::connectError(LoopPool* pool, Upstream* up, Connector* connector, int err)
+{
+    LOG_ERROR("UpstreamPool[%s] - connect to %s failed, error %d \n", name_.c_str(), up->addr.toIpPort().c_str(), err);
+    removeConnector(up, connector);
+    increase(pool->connectErrors);
+    if (!up->connectors.empty() || up->busy > 0)
+    {
+        return;
+    }
+    std::deque<Upstream::Waiter> failed;
+    failed.swap(up->waiters); // 回调中可能再checkout
+    for (const Upstream::Waiter& waiter : failed)
+    {
+        pool->checkoutLatency.record(LoopMetrics::nowNanos() - waiter.start);
+        waiter.cb(TcpConnectionPtr());
+    }
+}
+
+void UpstreamPool::giveBack(LoopPool* pool, Upstream* up, const TcpConnectionPtr& conn)
+{
+    if (!up->waiters.empty())
+    {
+        Upstream::Waiter waiter = std::move(up->waiters.front());
+        up->waiters.pop_front();
+        pool->checkoutLatency.record(LoopMetrics::nowNanos() - waiter.start);
+        waiter.cb(conn);
+    }
+    else if (up->idle.size() < maxIdle_)
+    {
+        --up->busy;
+        up->idle.push_back(Upstream::IdleConnection{ conn, LoopMetrics::nowNanos() });
+        startSweep(pool);
+        // release通常在使用者的messageCallback中调用，等它返回之后再换成空闲时的回调
+        pool->loop->queueInLoop(std::bind(&UpstreamPool::markIdle, this, pool, up, conn));
+    }
+    else
+    {
+        evict(pool, conn);
+    }
+}
+
+// 空闲时不应该收到数据，借出之后由使用者设置自己的messageCallback
+void UpstreamPool::markIdle(LoopPool* pool, Upstream* up, const TcpConnectionPtr& conn)
+{
+    if (!conn->connected())
+    {
+        return; // 正在关闭，连接池可能已经析构
+    }
+    for (const Upstream::IdleConnection& idle : up->idle)
+    {
+        if (idle.conn == conn)
+        {
+            conn->setMessageCallback(std::bind(&UpstreamPool::idleMessage, this, pool, _1, _2, _3));
+            break; // 不在idle中说明已经又被借出
+        }
+    }
+}
+
+// 关闭一个不在idle中的连接
+void UpstreamPool::evict(LoopPool* pool, const TcpConnectionPtr& conn)
+{
+    increase(pool->evictions);
+    conn->forceClose();
+}
+
+void UpstreamPool::idleMessage(LoopPool* pool, const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    LOG_INFO("UpstreamPool[%s] - unexpected data on idle connection %s \n", name_.c_str(), conn->name().c_str());
+    buf->retrieveAll();
+    Upstream* up = pool->owners[conn];
+    for (auto it = up->idle.begin(); it != up->idle.end(); ++it)
+    {
+        if (it->conn == conn)
+        {
+            up->idle.erase(it);
+            ++up->busy;
+            break;
+        }
+    }
+    evict(pool, conn);
+}
+
+void UpstreamPool::removeConnection(LoopPool* pool, const TcpConnectionPtr& conn)
+{
+    auto owner = pool->owners.find(conn);
+    if (owner != pool->owners.end())
+    {
+        Upstream* up = owner->second;
+        pool->owners.erase(owner);
+        bool wasIdle = false;
+        for (auto it = up->idle.begin(); it != up->idle.end(); ++it)
+        {
+            if (it->conn == conn)
+            {
+                up->idle.erase(it); // 空闲时被对端关闭
+                wasIdle = true;
+                break;
+            }
+        }
+        if (!wasIdle)
+        {
+            --up->busy;
+        }
+        if (up->connectors.size() < up->waiters.size() && up->total() < maxConnections_)
+        {
+            startConnect(pool, up);
+        }
+    }
+    pool->loop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+}
+
+void UpstreamPool::startSweep(LoopPool* pool)
+{
+    if (pool->sweeping)
+    {
+        return;
+    }
+    // 超时的精度是扫描间隔，最多晚1/4；不大于0的超时表示关闭，不参与计算
+    double interval = 0;
+    if (idleTimeout_ > 0)
+    {
+        interval = idleTimeout_ / 4;
+    }
+    if (checkoutTimeout_ > 0)
+    {
+        interval = interval > 0 ? std::min(interval, checkoutTimeout_ / 4) : checkoutTimeout_ / 4;
+    }
+    if (interval <= 0)
+    {
+        return;
+    }
+    pool->sweepTimer = pool->loop->runEvery(std::max(interval, 0.001), std::bind(&UpstreamPool::sweep, this, pool));
+    pool->sweeping = true;
+}
+
+// 关闭空闲太久的连接，等待超时的checkout回调nullptr
+void UpstreamPool::sweep(LoopPool* pool)
+{
+    const bool idleEnabled = idleTimeout_ > 0;
+    const bool checkoutEnabled = checkoutTimeout_ > 0;
+    uint64_t now = LoopMetrics::nowNanos();
+    uint64_t idleTimeout = idleEnabled ? static_cast<uint64_t>(idleTimeout_ * 1e9) : 0;
+    uint64_t checkoutTimeout = checkoutEnabled ? static_cast<uint64_t>(checkoutTimeout_ * 1e9) : 0;
+    std::vector<CheckoutCallback> expired; // 遍历完再回调，回调中可能再checkout
+    bool pending = false; // 还有没到时间的空闲连接或者等待者
+    for (auto& item : pool->upstreams)
+    {
+        Upstream* up = item.second.get();
+        while (idleEnabled && !up->idle.empty() && now - up->idle.front().since >= idleTimeout)
+        {
+            TcpConnectionPtr conn = std::move(up->idle.front().conn);
+            up->idle.pop_front();
+            ++up->busy;
+            evict(pool, conn);
+        }
+        while (checkoutEnabled && !up->waiters.empty() && now - up->waiters.front().start >= checkoutTimeout)
+        {
+            expired.push_back(std::move(up->waiters.front().cb));
+            up->waiters.pop_front();
+            increase(pool->timeouts);
+        }
+        pending = pending || (idleEnabled && !up->idle.empty()) || (checkoutEnabled && !up->waiters.empty());
+    }
+    if (!pending)
+    {
+        pool->loop->cancel(pool->sweepTimer); // 在自己的回调中取消，这一次回调之后不再触发
+        pool->sweeping = false;
+    }
+    for (const CheckoutCallback& cb : expired)
+    {
+        cb(TcpConnectionPtr());
+    }
+}
+
+void UpstreamPool::shutdown(LoopPool* pool)
+{
+    if (pool->sweeping)
+    {
+        pool->loop->cancel(pool->sweepTimer);
+    }
+    for (auto& item : pool->upstreams)
+    {
+        for (const ConnectorPtr& connector : item.second->connectors)
+        {
+            connector->stop();
+        }
+    }
+    for (auto& item : pool->owners)
+    {
+        const TcpConnectionPtr& conn = item.first;
+        conn->setMessageCallback(defaultMessageCallback);
+        conn->setCloseCallback(destroyConnection);
+        conn->forceClose();
+    }
+    pool->owners.clear();
+    pool->upstreams.clear();
+}
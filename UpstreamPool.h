@@ -0,0 +1,98 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callback.h"
+#include "InetAddress.h"
+#include "LoopMetrics.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Connector;
+class EventLoop;
+
+/**
+ * 出站连接池：按后端地址、按EventLoop分别保存空闲连接
+ * loop N上的handler只从loop N自己的池中借连接，连接也属于loop N，借还都不加锁、不跨线程
+ * 没有空闲连接时排队等待，连接数未到上限就新建连接；等待超过checkoutTimeout时回调nullptr
+ * connect遇到不会重试的错误、且没有别的连接能交给等待者时，等待者立即回调nullptr
+ * 空闲超过idleTimeout、对端关闭、空闲时收到数据、归还时标记不可复用的连接都会被关闭
+ *
+ * 借到连接之后由使用者设置自己的messageCallback，release可以在这个回调中调用
+ * 构造时传入会用到的所有loop，之后不能再增加；checkout/release只能在对应的loop线程中调用
+*/
+class UpstreamPool : noncopyable
+{
+public:
+    // 拿到的连接，失败或超时时为nullptr
+    using CheckoutCallback = std::function<void(const TcpConnectionPtr&)>;
+
+    struct Stats
+    {
+        uint64_t checkouts; // checkout的次数
+        uint64_t hits; // 直接拿到空闲连接的次数
+        uint64_t timeouts; // 等待超时的次数
+        uint64_t connects; // 新建的连接数
+        uint64_t connectErrors; // connect失败且不再重试的次数
+        uint64_t evictions; // 因为空闲超时、不健康等原因关闭的连接数
+        Histogram::Snapshot checkoutLatency; // 从checkout到回调的时间，纳秒
+
+        Stats();
+        void merge(const Stats& other);
+        double hitRate() const { return checkouts ? static_cast<double>(hits) / checkouts : 0; }
+    };
+
+    UpstreamPool(const std::vector<EventLoop*>& loops, const std::string& name);
+    // 在各个loop中关闭所有连接，需要在loop还在运行、且不在这些loop线程中时析构
+    ~UpstreamPool();
+
+    // 以下设置需要在第一次checkout之前调用
+    // 每个loop、每个后端最多保留的空闲连接数，0表示不复用
+    void setMaxIdle(size_t n) { maxIdle_ = n; }
+    // 每个loop、每个后端最多的连接数（空闲 + 借出 + 正在连接）
+    void setMaxConnections(size_t n) { maxConnections_ = n; }
+    // 空闲连接超过seconds秒没有被借出就关闭，0表示不因为空闲关闭
+    void setIdleTimeout(double seconds) { idleTimeout_ = seconds; }
+    // 排队等待连接的超时时间，0表示一直等待
+    void setCheckoutTimeout(double seconds) { checkoutTimeout_ = seconds; }
+
+    // 在loop线程中调用，有空闲连接时直接回调
+    void checkout(EventLoop* loop, const InetAddress& addr, const CheckoutCallback& cb);
+    // 在连接所在的loop线程中调用；reusable为false或者连接已经断开时关闭连接
+    void release(const TcpConnectionPtr& conn, bool reusable = true);
+
+    // 所有loop的统计之和，线程安全
+    Stats stats() const;
+
+private:
+    struct LoopPool;
+    struct Upstream;
+
+    LoopPool* poolOf(EventLoop* loop) const;
+    void startConnect(LoopPool* pool, Upstream* up);
+    void newConnection(LoopPool* pool, Upstream* up, Connector* connector, int sockfd);
+    void connectError(LoopPool* pool, Upstream* up, Connector* connector, int err);
+    void removeConnector(Upstream* up, Connector* connector);
+    // 连接回到池中：有等待者时直接交给它，否则放入空闲列表，空闲列表满了就关闭
+    void giveBack(LoopPool* pool, Upstream* up, const TcpConnectionPtr& conn);
+    void markIdle(LoopPool* pool, Upstream* up, const TcpConnectionPtr& conn);
+    void evict(LoopPool* pool, const TcpConnectionPtr& conn);
+    void idleMessage(LoopPool* pool, const TcpConnectionPtr& conn, Buffer* buf, Timestamp time);
+    void removeConnection(LoopPool* pool, const TcpConnectionPtr& conn);
+    // 有空闲连接或者等待者需要按时间处理时启动扫描的定时器，没有可扫描的之后定时器自己停止
+    void startSweep(LoopPool* pool);
+    void sweep(LoopPool* pool);
+    void shutdown(LoopPool* pool);
+
+    const std::string name_;
+    size_t maxIdle_;
+    size_t maxConnections_;
+    double idleTimeout_;
+    double checkoutTimeout_;
+    std::atomic_int nextConnId_; // 只在新建连接时使用
+    std::unordered_map<EventLoop*, std::unique_ptr<LoopPool>> pools_; // 构造之后只读
+};
@@ -0,0 +1,189 @@
+#include <mymuduo/Acceptor.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/InetAddress.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <vector>
+
+/**
+ * 连接风暴下Acceptor每秒能accept多少连接
+ * storm：子进程中clients个线程不停地connect再RST关闭，父进程的Acceptor accept之后直接close，
+ *        比较每次可读事件accept 1个和批量accept的吞吐，以及io_uring下可读再accept和multishot accept，
+ *        同时统计loop线程每accept一个连接的CPU时间
+ * emfile：把fd上限调低，子进程建立远多于上限的连接并保持住，
+ *         统计loop线程的CPU占用，fd耗尽时不应该空转
+ * ./acceptbench [seconds] [clients]
+*/
+
+static const uint16_t kPort = 9016;
+
+// 子进程：clients个线程在seconds秒内不停地建立连接
+static void stormClients(int clients, double seconds)
+{
+    std::vector<std::thread> threads;
+    Timestamp deadline = addTime(Timestamp::now(), seconds);
+    for (int i = 0; i < clients; ++i)
+    {
+        threads.emplace_back([deadline]() {
+            sockaddr_in addr;
+            memset(&addr, 0, sizeof addr);
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(kPort);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            while (Timestamp::now() < deadline)
+            {
+                int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+                if (::connect(fd, (sockaddr*)&addr, sizeof addr) == 0)
+                {
+                    // 发RST关闭，客户端不留TIME_WAIT，端口不会耗尽
+                    linger lg = { 1, 0 };
+                    ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof lg);
+                }
+                ::close(fd);
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
+
+// 子进程：建立count个连接，保持到seconds秒之后
+static void holdClients(int count, double seconds)
+{
+    std::vector<int> fds;
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(kPort);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < count; ++i)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        ::connect(fd, (sockaddr*)&addr, sizeof addr);
+        fds.push_back(fd);
+    }
+    usleep(static_cast<useconds_t>(seconds * 1000 * 1000));
+    for (int fd : fds)
+    {
+        ::close(fd);
+    }
+}
+
+static double threadCpuSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// 运行loop seconds秒，child是客户端进程的入口
+template <typename Child>
+static void runWithClients(EventLoop* loop, double seconds, Child child)
+{
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+        child();
+        _exit(0);
+    }
+    loop->runAfter(seconds, [loop]() { loop->quit(); });
+    loop->loop();
+    ::kill(pid, SIGKILL);
+    ::waitpid(pid, nullptr, 0);
+}
+
+static void storm(const char* name, Poller::Backend backend, int batch, bool multishot, int clients, double seconds)
+{
+    EventLoop loop(backend);
+    Acceptor acceptor(&loop, InetAddress(kPort), false);
+    long accepted = 0;
+    acceptor.setAcceptBatch(batch);
+    acceptor.setMultishotAccept(multishot);
+    acceptor.setNewConnectionCallback([&](int sockfd, const InetAddress&) {
+        ::close(sockfd);
+        ++accepted;
+    });
+    acceptor.listen();
+
+    double cpuStart = threadCpuSeconds();
+    runWithClients(&loop, seconds, [=]() { stormClients(clients, seconds); });
+    double cpu = threadCpuSeconds() - cpuStart;
+    uint64_t iterations = loop.metrics().snapshot().iterations;
+
+    char mode[32];
+    if (acceptor.multishotAccept())
+    {
+        snprintf(mode, sizeof mode, "multishot");
+    }
+    else
+    {
+        snprintf(mode, sizeof mode, "batch %d%s", batch, multishot ? " (no multishot)" : "");
+    }
+    printf("%-9s %-10s %10.0f accepts/s %8.2f us cpu/accept %6.2f accepts/poll\n", name, mode,
+        accepted / seconds, accepted > 0 ? cpu * 1e6 / accepted : 0.0,
+        iterations > 0 ? static_cast<double>(accepted) / iterations : 0.0);
+}
+
+static void emfile(const char* name, Poller::Backend backend, double seconds)
+{
+    const int kLimit = 64;
+    const int kConnections = 512;
+
+    rlimit saved;
+    ::getrlimit(RLIMIT_NOFILE, &saved);
+    EventLoop loop(backend);
+    Acceptor acceptor(&loop, InetAddress(kPort), false);
+    std::vector<int> held;
+    acceptor.setNewConnectionCallback([&](int sockfd, const InetAddress&) {
+        held.push_back(sockfd); // 不关闭，直到fd耗尽
+    });
+    acceptor.listen();
+
+    rlimit limit = saved;
+    limit.rlim_cur = kLimit;
+    ::setrlimit(RLIMIT_NOFILE, &limit);
+    double cpuStart = threadCpuSeconds();
+    runWithClients(&loop, seconds, [=]() { holdClients(kConnections, seconds + 1); });
+    double cpu = threadCpuSeconds() - cpuStart;
+    ::setrlimit(RLIMIT_NOFILE, &saved);
+
+    printf("emfile %-9s %d connections, fd limit %d, held %zu, loop cpu %.1f%%\n",
+        name, kConnections, kLimit, held.size(), cpu * 100 / seconds);
+    for (int fd : held)
+    {
+        ::close(fd);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    int clients = argc > 2 ? atoi(argv[2]) : 4;
+    Logger::setLogLevel(FATAL);
+
+    printf("%d client thread(s), %.1f s per run\n", clients, seconds);
+    const int batches[] = { 1, 4, 16, 64 };
+    for (int batch : batches)
+    {
+        storm("epoll", Poller::kEPoll, batch, false, clients, seconds);
+    }
+    storm("io_uring", Poller::kIoUring, Acceptor::kDefaultAcceptBatch, false, clients, seconds);
+    storm("io_uring", Poller::kIoUring, Acceptor::kDefaultAcceptBatch, true, clients, seconds);
+    emfile("epoll", Poller::kEPoll, seconds);
+    emfile("io_uring", Poller::kIoUring, seconds);
+    return 0;
+}
@@ -0,0 +1,321 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpConnection.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 负载不均衡时各策略下每个subloop的尾延迟
+ * 4个subloop，4个长连接的重客户端：每个请求服务器先占用200us的CPU，再回复512KB
+ * 12个轻客户端：16字节一问一答，每20个请求断开重连
+ * 先按 重 轻 轻 轻 重 ... 的顺序建立连接，轮询时重连接全部落到同一个loop
+ * 每个客户端用不同的127.0.0.x地址，一致性哈希时按客户端分配
+ * 统计轻客户端的请求在各loop上的p50/p99延迟
+ * ./balancebench [seconds]
+*/
+
+static const int kLoops = 4;
+static const int kHeavyClients = 4;
+static const int kLightClients = 12;
+static const int kRequestsPerConnection = 20;
+static const size_t kMessageSize = 16;
+static const size_t kHeavyReplySize = 512 * 1024;
+static const double kHeavyWorkSeconds = 200e-6;
+
+static __thread int t_loopIndex = -1;
+
+struct Sample
+{
+    int loop;
+    double us;
+};
+
+class Client
+{
+public:
+    Client(uint16_t port, int ipIndex)
+        : port_(port)
+        , ipIndex_(ipIndex)
+        , fd_(-1)
+        , loop_(-1)
+    {
+    }
+
+    ~Client() { disconnect(); }
+
+    // 连接并读取服务器发来的loop编号
+    bool connect()
+    {
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in local;
+        memset(&local, 0, sizeof local);
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(0x7f000000 | ipIndex_);
+        ::bind(fd_, reinterpret_cast<sockaddr*>(&local), sizeof local);
+
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof addr);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port_);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0)
+        {
+            return false;
+        }
+        int one = 1;
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        char index;
+        if (!readExactly(&index, 1))
+        {
+            return false;
+        }
+        loop_ = index;
+        return true;
+    }
+
+    void disconnect()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    // 发送一个请求，读完replySize字节的回复，返回耗时（微秒），失败返回负数
+    double request(char type, size_t replySize)
+    {
+        std::string msg(kMessageSize, type);
+        Timestamp start = Timestamp::now();
+        if (::write(fd_, msg.data(), msg.size()) != static_cast<ssize_t>(msg.size()))
+        {
+            return -1;
+        }
+        buf_.resize(std::min(replySize, static_cast<size_t>(64 * 1024)));
+        size_t got = 0;
+        while (got < replySize)
+        {
+            size_t want = std::min(replySize - got, buf_.size());
+            if (!readExactly(&buf_[0], want))
+            {
+                return -1;
+            }
+            got += want;
+        }
+        return timeDifference(Timestamp::now(), start) * 1e6;
+    }
+
+    int loop() const { return loop_; }
+
+private:
+    bool readExactly(char* buf, size_t len)
+    {
+        while (len > 0)
+        {
+            ssize_t n = ::read(fd_, buf, len);
+            if (n <= 0)
+            {
+                return false;
+            }
+            buf += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    uint16_t port_;
+    int ipIndex_;
+    int fd_;
+    int loop_;
+    std::vector<char> buf_;
+};
+
+static void burnCpu(double seconds)
+{
+    Timestamp start = Timestamp::now();
+    while (timeDifference(Timestamp::now(), start) < seconds)
+    {
+    }
+}
+
+static double percentile(std::vector<double>& v, double p)
+{
+    if (v.empty())
+    {
+        return 0;
+    }
+    size_t k = static_cast<size_t>(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static void run(const char* name, LoadBalancer::Policy policy, uint16_t port, double seconds)
+{
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(port), "BalanceBench");
+    std::atomic_int nextIndex(0);
+    server.setThreadNum(kLoops);
+    server.setLoadBalancePolicy(policy);
+    server.setThreadInitCallback([&](EventLoop*) { t_loopIndex = nextIndex++; });
+
+    auto heavyReply = std::make_shared<const std::string>(kHeavyReplySize, 'h');
+    server.setConnectionCallback([](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+            conn->send(std::string(1, static_cast<char>(t_loopIndex)));
+        }
+    });
+    server.setMessageCallback([heavyReply](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        while (buf->readableBytes() >= kMessageSize)
+        {
+            std::string msg = buf->retrieveAsString(kMessageSize);
+            if (msg[0] == 'H')
+            {
+                burnCpu(kHeavyWorkSeconds);
+                conn->send(heavyReply);
+            }
+            else
+            {
+                conn->send(msg);
+            }
+        }
+    });
+    server.start();
+
+    std::atomic_bool stop(false);
+    std::mutex mutex;
+    std::vector<Sample> samples;
+    std::vector<int> heavyPerLoop(kLoops, 0);
+    std::vector<int> lightConnsPerLoop(kLoops, 0);
+    std::vector<std::thread> threads;
+
+    // 建立连接时需要baseloop accept，客户端在单独的线程中驱动
+    std::thread driver([&]() {
+        usleep(100 * 1000);
+        // 按 重 轻 轻 轻 重 ... 的顺序依次建立第一批连接
+        std::vector<std::unique_ptr<Client>> heavy, light;
+        for (int i = 0; i < kHeavyClients + kLightClients; ++i)
+        {
+            bool isHeavy = i % kLoops == 0 && static_cast<int>(heavy.size()) < kHeavyClients;
+            std::unique_ptr<Client> client(new Client(port, 2 + i));
+            if (!client->connect())
+            {
+                perror("connect");
+                exit(1);
+            }
+            if (isHeavy)
+            {
+                ++heavyPerLoop[client->loop()];
+                heavy.push_back(std::move(client));
+            }
+            else
+            {
+                ++lightConnsPerLoop[client->loop()];
+                light.push_back(std::move(client));
+            }
+        }
+
+        for (auto& c : heavy)
+        {
+            Client* client = c.release();
+            threads.emplace_back([&stop, client]() {
+                while (!stop && client->request('H', kHeavyReplySize) >= 0)
+                {
+                }
+                delete client;
+            });
+        }
+        for (auto& c : light)
+        {
+            Client* client = c.release();
+            threads.emplace_back([&, client]() {
+                std::vector<Sample> local;
+                int requests = 0;
+                while (!stop)
+                {
+                    double us = client->request('L', kMessageSize);
+                    if (us < 0)
+                    {
+                        break;
+                    }
+                    local.push_back(Sample{ client->loop(), us });
+                    if (++requests % kRequestsPerConnection == 0)
+                    {
+                        client->disconnect();
+                        if (!client->connect())
+                        {
+                            break;
+                        }
+                        std::lock_guard<std::mutex> lock(mutex);
+                        ++lightConnsPerLoop[client->loop()];
+                    }
+                }
+                delete client;
+                std::lock_guard<std::mutex> lock(mutex);
+                samples.insert(samples.end(), local.begin(), local.end());
+            });
+        }
+
+        usleep(static_cast<useconds_t>(seconds * 1000 * 1000));
+        stop = true;
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+
+    printf("%s\n", name);
+    printf("  %4s %6s %11s %9s %10s %10s\n", "loop", "heavy", "light conns", "requests", "p50(us)", "p99(us)");
+    for (int i = 0; i < kLoops; ++i)
+    {
+        std::vector<double> us;
+        for (const Sample& s : samples)
+        {
+            if (s.loop == i)
+            {
+                us.push_back(s.us);
+            }
+        }
+        size_t requests = us.size();
+        double p50 = percentile(us, 0.50);
+        double p99 = percentile(us, 0.99);
+        printf("  %4d %6d %11d %9zu %10.0f %10.0f\n", i, heavyPerLoop[i], lightConnsPerLoop[i], requests, p50, p99);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    Logger::setLogLevel(ERROR);
+
+    const struct { const char* name; LoadBalancer::Policy policy; } policies[] = {
+        { "round-robin", LoadBalancer::kRoundRobin },
+        { "least-connections", LoadBalancer::kLeastConnections },
+        { "least-pending-bytes", LoadBalancer::kLeastPendingBytes },
+        { "consistent-hash", LoadBalancer::kConsistentHash },
+    };
+    uint16_t port = 8017;
+    for (const auto& p : policies)
+    {
+        run(p.name, p.policy, port++, seconds);
+    }
+    return 0;
+}
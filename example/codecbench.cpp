@@ -0,0 +1,168 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/LengthHeaderCodec.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 长度前缀分帧的echo服务器，比较两种编解码方式
+ * string：retrieveAsString取出帧，再拼接长度头和内容成std::string发送，每帧两次拷贝两次申请内存
+ * in-place：LengthHeaderCodec在输入Buffer上取出帧，内容写入输出Buffer后原地prepend长度头发送，每帧一次拷贝
+ * 客户端每次发送kBatch帧再读回全部的echo，统计每秒的帧数和吞吐
+ * ./codecbench [seconds]
+*/
+
+static const uint16_t kPort = 9024;
+static const int kBatch = 16;
+
+static void stringMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp)
+{
+    while (buf->readableBytes() >= sizeof(int32_t))
+    {
+        int32_t be;
+        ::memcpy(&be, buf->peek(), sizeof be);
+        size_t len = ntohl(be);
+        if (buf->readableBytes() < sizeof be + len)
+        {
+            break;
+        }
+        buf->retrieve(sizeof be);
+        std::string message = buf->retrieveAsString(len);
+        std::string frame(reinterpret_cast<const char*>(&be), sizeof be);
+        frame += message;
+        conn->send(frame);
+    }
+}
+
+class Client
+{
+public:
+    explicit Client(size_t frameSize)
+        : fd_(::socket(AF_INET, SOCK_STREAM, 0))
+    {
+        std::string frame(sizeof(int32_t) + frameSize, 'x');
+        uint32_t be = htonl(static_cast<uint32_t>(frameSize));
+        ::memcpy(&frame[0], &be, sizeof be);
+        for (int i = 0; i < kBatch; ++i)
+        {
+            batch_ += frame;
+        }
+        input_.resize(batch_.size());
+    }
+
+    ~Client() { ::close(fd_); }
+
+    bool connect()
+    {
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof addr);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kPort);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int one = 1;
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        return ::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0;
+    }
+
+    // 发出一批帧，读回同样多的字节；服务器的输出缓冲区不限大小，先写完再读不会互相阻塞
+    bool roundTrip()
+    {
+        if (::write(fd_, batch_.data(), batch_.size()) != static_cast<ssize_t>(batch_.size()))
+        {
+            return false;
+        }
+        size_t got = 0;
+        while (got < input_.size())
+        {
+            ssize_t n = ::read(fd_, &input_[got], input_.size() - got);
+            if (n <= 0)
+            {
+                return false;
+            }
+            got += n;
+        }
+        return true;
+    }
+
+    size_t batchBytes() const { return batch_.size(); }
+
+private:
+    int fd_;
+    std::string batch_;
+    std::vector<char> input_;
+};
+
+static void run(const char* name, bool inPlace, size_t frameSize, double seconds)
+{
+    EventLoop loop;
+    TcpServer server(&loop, InetAddress(kPort), "CodecBench");
+    Buffer output; // 单线程的服务器，所有连接共用一个输出Buffer
+    LengthHeaderCodec codec([&](const TcpConnectionPtr& conn, const StringPiece& frame, Timestamp) {
+        output.append(frame.data(), frame.size());
+        codec.send(conn, &output);
+    });
+    if (inPlace)
+    {
+        server.setMessageCallback(std::bind(&LengthHeaderCodec::onMessage, &codec,
+            std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    }
+    else
+    {
+        server.setMessageCallback(stringMessage);
+    }
+    server.setConnectionCallback([](const TcpConnectionPtr& conn) {
+        if (conn->connected())
+        {
+            conn->setTcpNoDelay(true);
+        }
+    });
+    server.start();
+
+    long batches = 0;
+    size_t batchBytes = 0;
+    std::thread client([&]() {
+        Client c(frameSize);
+        batchBytes = c.batchBytes();
+        if (c.connect())
+        {
+            Timestamp deadline = addTime(Timestamp::now(), seconds);
+            while (Timestamp::now() < deadline && c.roundTrip())
+            {
+                ++batches;
+            }
+        }
+        loop.runInLoop([&loop]() { loop.quit(); });
+    });
+    loop.loop();
+    client.join();
+
+    printf("%-9s %8zu %12.0f %10.1f\n", name, frameSize,
+        batches * kBatch / seconds, batches * batchBytes / seconds / (1024 * 1024));
+}
+
+int main(int argc, char* argv[])
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 1.0;
+    Logger::setLogLevel(ERROR);
+
+    printf("%d frames per round trip, %.1f s per run\n", kBatch, seconds);
+    printf("%-9s %8s %12s %10s\n", "codec", "size", "frames/s", "MB/s");
+    const size_t sizes[] = { 64, 1024, 16 * 1024, 256 * 1024 };
+    for (size_t size : sizes)
+    {
+        run("string", false, size, seconds);
+        run("in-place", true, size, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpConnection.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 同一个echo服务器分别使用epoll、poll和io_uring的吞吐
+ * 服务器和testserver一样原样回显，但不在回显之后关闭连接；客户端每个连接一个线程，阻塞地一问一答
+ * ./echobench [epoll|poll|io_uring] [connections] [seconds] [messageSize] [et]
+*/
+
+static std::atomic_bool g_stop(false);
+
+static void clientThread(uint16_t port, size_t msgSize, std::atomic<long>* total)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+
+    std::string msg(msgSize, 'x');
+    std::vector<char> reply(msgSize);
+    long count = 0;
+    while (!g_stop)
+    {
+        if (::write(fd, msg.data(), msg.size()) != static_cast<ssize_t>(msg.size()))
+        {
+            break;
+        }
+        size_t got = 0;
+        while (got < msgSize)
+        {
+            ssize_t n = ::read(fd, &reply[got], msgSize - got);
+            if (n <= 0)
+            {
+                ::close(fd);
+                return;
+            }
+            got += n;
+        }
+        ++count;
+    }
+    *total += count;
+    ::close(fd);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* backendName = argc > 1 ? argv[1] : "epoll";
+    Poller::Backend backend = Poller::kEPoll;
+    if (strcmp(backendName, "io_uring") == 0)
+    {
+        backend = Poller::kIoUring;
+    }
+    else if (strcmp(backendName, "poll") == 0)
+    {
+        backend = Poller::kPoll;
+    }
+    int connections = argc > 2 ? atoi(argv[2]) : 16;
+    int seconds = argc > 3 ? atoi(argv[3]) : 5;
+    size_t msgSize = argc > 4 ? static_cast<size_t>(atoi(argv[4])) : 64;
+    bool edgeTriggered = argc > 5 && strcmp(argv[5], "et") == 0;
+    Logger::setLogLevel(ERROR);
+
+    const uint16_t port = 8001;
+    EventLoop loop(backend);
+    InetAddress addr(port);
+    TcpServer server(&loop, addr, "EchoBench");
+    server.setThreadNum(2);
+    server.setPollerBackend(backend);
+    server.setEdgeTriggered(edgeTriggered);
+    server.setConnectionCallback([](const TcpConnectionPtr&) {});
+    server.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        conn->send(buf->retrieveAllAsString());
+    });
+    server.start();
+
+    std::atomic<long> total(0);
+    std::vector<std::thread> clients;
+    loop.runAfter(0.1, [&]() {
+        for (int i = 0; i < connections; ++i)
+        {
+            clients.emplace_back(clientThread, port, msgSize, &total);
+        }
+    });
+    loop.runAfter(0.1 + seconds, [&]() {
+        g_stop = true;
+        for (std::thread& t : clients)
+        {
+            t.join();
+        }
+        loop.quit();
+    });
+    loop.loop();
+
+    printf("%-8s %s %d connections %zu bytes: %.0f echo/s\n",
+           backendName,
+           edgeTriggered ? "ET" : "LT",
+           connections, msgSize, static_cast<double>(total) / seconds);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/Logger.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <string>
+
+/**
+ * 通过echo服务器一样的TcpServer发送一个大文件，比较两种方式的吞吐：
+ * copy    ：read到std::string后调用TcpConnection::send，数据经过用户态和outputBuffer_
+ * sendfile：TcpConnection::sendFile，数据直接从page cache写到socket
+ * ./filebench [file] [sizeMB]，文件不存在时先创建（默认1GB）
+*/
+
+static const uint16_t kPort = 9100;
+
+static void createFile(const char* path, size_t size)
+{
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    std::string chunk(1024 * 1024, 'x');
+    for (size_t written = 0; written < size; written += chunk.size())
+    {
+        ::write(fd, chunk.data(), chunk.size());
+    }
+    ::close(fd);
+}
+
+class FileServer
+{
+public:
+    FileServer(EventLoop* loop, const InetAddress& addr, const char* path, size_t size)
+        : server_(loop, addr, "FileServer")
+        , path_(path)
+        , size_(size)
+        , useSendfile_(false)
+    {
+        server_.setConnectionCallback([this](const TcpConnectionPtr& conn) { onConnection(conn); });
+        server_.setMessageCallback([](const TcpConnectionPtr&, Buffer* buf, Timestamp) { buf->retrieveAll(); });
+        server_.setThreadNum(1);
+    }
+
+    void start() { server_.start(); }
+    void setUseSendfile(bool on) { useSendfile_ = on; }
+
+private:
+    void onConnection(const TcpConnectionPtr& conn)
+    {
+        if (!conn->connected())
+        {
+            return;
+        }
+        int fd = ::open(path_, O_RDONLY | O_CLOEXEC);
+        if (useSendfile_)
+        {
+            conn->sendFile(fd, 0, size_);
+        }
+        else
+        {
+            const size_t kChunk = 64 * 1024 * 1024;
+            std::string data;
+            for (size_t off = 0; off < size_; off += kChunk)
+            {
+                size_t len = size_ - off < kChunk ? size_ - off : kChunk;
+                data.resize(len);
+                ::pread(fd, &*data.begin(), len, off);
+                conn->send(data);
+            }
+        }
+        ::close(fd);
+    }
+
+    TcpServer server_;
+    const char* path_;
+    size_t size_;
+    bool useSendfile_;
+};
+
+static double fetch(size_t size)
+{
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    InetAddress addr(kPort);
+    ::connect(sockfd, (const sockaddr*)addr.getSockAddr(), sizeof(sockaddr_in));
+    Timestamp start(Timestamp::now());
+    static char buf[1024 * 1024];
+    size_t total = 0;
+    while (total < size)
+    {
+        ssize_t n = ::read(sockfd, buf, sizeof buf);
+        if (n <= 0)
+        {
+            break;
+        }
+        total += n;
+    }
+    double seconds = timeDifference(Timestamp::now(), start);
+    ::close(sockfd);
+    return seconds;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* path = argc > 1 ? argv[1] : "/tmp/filebench.dat";
+    size_t size = (argc > 2 ? atol(argv[2]) : 1024) * 1024 * 1024;
+    Logger::setLogLevel(ERROR);
+
+    struct stat st;
+    if (::stat(path, &st) != 0 || static_cast<size_t>(st.st_size) < size)
+    {
+        createFile(path, size);
+    }
+
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+    FileServer* server = nullptr;
+    loop->runInLoop([&]() {
+        server = new FileServer(loop, InetAddress(kPort), path, size);
+        server->start();
+    });
+    ::usleep(100 * 1000);
+
+    const char* names[] = { "copy", "sendfile" };
+    for (int i = 0; i < 2; ++i)
+    {
+        loop->runInLoop([server, i]() { server->setUseSendfile(i == 1); });
+        fetch(size); // 预热page cache
+        double seconds = fetch(size);
+        fprintf(stderr, "%-9s %6zu MB  %6.3f s  %8.1f MB/s\n",
+               names[i], size >> 20, seconds, (size >> 20) / seconds);
+    }
+    ::_exit(0);
+}
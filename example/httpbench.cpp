@@ -0,0 +1,268 @@
+#include <mymuduo/HttpServer.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 类似wrk的本地HTTP压测：HttpServer和客户端在同一个进程中
+ * connections个客户端线程各自持有一个连接，在seconds秒内不停地发请求，统计每秒请求数和延迟
+ * keep-alive：一问一答
+ * pipeline：一次发出kPipelineDepth个请求再读回全部应答，延迟按一批统计
+ * close：每个请求都带Connection: close，重新建立连接
+ * chunked：应答由多个块组成，writeChunk直接写入输出
+ * ./httpbench [seconds] [connections]
+*/
+
+static const uint16_t kPort = 9023;
+static const int kServerThreads = 2;
+static const int kPipelineDepth = 16;
+static const int kChunks = 4;
+static const size_t kChunkSize = 1024;
+
+static void onRequest(const HttpRequest& req, HttpResponse* resp)
+{
+    if (req.path() == "/")
+    {
+        resp->setContentType("text/plain");
+        resp->setBody("Hello, World!");
+    }
+    else if (req.path() == "/chunked")
+    {
+        resp->setContentType("text/plain");
+        static const std::string chunk(kChunkSize, 'c');
+        for (int i = 0; i < kChunks; ++i)
+        {
+            resp->writeChunk(chunk);
+        }
+    }
+    else
+    {
+        resp->setStatusCode(HttpResponse::k404NotFound);
+    }
+}
+
+class Client
+{
+public:
+    Client()
+        : fd_(-1)
+        , responseLength_(0)
+    {
+    }
+
+    ~Client() { disconnect(); }
+
+    bool connect()
+    {
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof addr);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(kPort);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0)
+        {
+            return false;
+        }
+        int one = 1;
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        return true;
+    }
+
+    void disconnect()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    // 发出depth个请求，读回全部应答，返回耗时（微秒），失败返回负数
+    double request(const std::string& req, int depth)
+    {
+        std::string batch;
+        for (int i = 0; i < depth; ++i)
+        {
+            batch += req;
+        }
+        Timestamp start = Timestamp::now();
+        if (::write(fd_, batch.data(), batch.size()) != static_cast<ssize_t>(batch.size()))
+        {
+            return -1;
+        }
+        if (responseLength_ == 0 && !learnResponseLength())
+        {
+            return -1;
+        }
+        // 同一个路径的应答完全相同，按第一个应答的长度读
+        size_t want = responseLength_ * depth;
+        while (input_.size() < want)
+        {
+            if (!readMore())
+            {
+                return -1;
+            }
+        }
+        input_.erase(0, want);
+        return timeDifference(Timestamp::now(), start) * 1e6;
+    }
+
+    void forget() { responseLength_ = 0; input_.clear(); }
+
+private:
+    bool readMore()
+    {
+        char buf[64 * 1024];
+        ssize_t n = ::read(fd_, buf, sizeof buf);
+        if (n <= 0)
+        {
+            return false;
+        }
+        input_.append(buf, n);
+        return true;
+    }
+
+    // 读完第一个应答，确定应答的长度
+    bool learnResponseLength()
+    {
+        size_t headerEnd;
+        while ((headerEnd = input_.find("\r\n\r\n")) == std::string::npos)
+        {
+            if (!readMore())
+            {
+                return false;
+            }
+        }
+        if (input_.compare(0, 12, "HTTP/1.1 200") != 0)
+        {
+            fprintf(stderr, "unexpected response: %s\n", input_.substr(0, headerEnd).c_str());
+            return false;
+        }
+        headerEnd += 4;
+        size_t pos = input_.find("Content-Length: ");
+        if (pos != std::string::npos && pos < headerEnd)
+        {
+            responseLength_ = headerEnd + atoi(input_.c_str() + pos + 16);
+            return true;
+        }
+        size_t end;
+        while ((end = input_.find("\r\n0\r\n\r\n", headerEnd - 2)) == std::string::npos)
+        {
+            if (!readMore())
+            {
+                return false;
+            }
+        }
+        responseLength_ = end + 7;
+        return true;
+    }
+
+    int fd_;
+    size_t responseLength_;
+    std::string input_;
+};
+
+static double percentile(std::vector<double>& v, double p)
+{
+    if (v.empty())
+    {
+        return 0;
+    }
+    size_t k = static_cast<size_t>(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static void run(const char* name, const char* path, int depth, bool close, int connections, double seconds)
+{
+    std::string req = std::string("GET ") + path + " HTTP/1.1\r\nHost: localhost\r\nUser-Agent: httpbench\r\n";
+    req += close ? "Connection: close\r\n\r\n" : "\r\n";
+
+    std::atomic_bool stop(false);
+    std::atomic_long requests(0);
+    std::atomic_long errors(0);
+    std::mutex mutex;
+    std::vector<double> latencies;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < connections; ++i)
+    {
+        threads.emplace_back([&]() {
+            Client client;
+            std::vector<double> local;
+            long done = 0;
+            bool connected = client.connect();
+            while (connected && !stop)
+            {
+                double us = client.request(req, depth);
+                if (us < 0)
+                {
+                    ++errors;
+                    break;
+                }
+                local.push_back(us);
+                done += depth;
+                if (close)
+                {
+                    client.disconnect();
+                    client.forget();
+                    connected = client.connect();
+                }
+            }
+            requests += done;
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.insert(latencies.end(), local.begin(), local.end());
+        });
+    }
+    usleep(static_cast<useconds_t>(seconds * 1000 * 1000));
+    stop = true;
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    double p50 = percentile(latencies, 0.50);
+    double p99 = percentile(latencies, 0.99);
+    printf("%-12s %10.0f %10.0f %10.0f %7ld\n", name, requests / seconds, p50, p99, errors.load());
+}
+
+int main(int argc, char* argv[])
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+    int connections = argc > 2 ? atoi(argv[2]) : 8;
+    Logger::setLogLevel(ERROR);
+
+    EventLoop loop;
+    HttpServer server(&loop, InetAddress(kPort), "HttpBench");
+    server.setThreadNum(kServerThreads);
+    server.setHttpCallback(onRequest);
+    server.start();
+
+    std::thread driver([&]() {
+        printf("%d server threads, %d connections, %.1f s per run, latency per round trip\n",
+            kServerThreads, connections, seconds);
+        printf("%-12s %10s %10s %10s %7s\n", "mode", "req/s", "p50(us)", "p99(us)", "errors");
+        run("keep-alive", "/", 1, false, connections, seconds);
+        run("pipeline", "/", kPipelineDepth, false, connections, seconds);
+        run("close", "/", 1, true, connections, seconds);
+        run("chunked", "/chunked", 1, false, connections, seconds);
+        loop.quit();
+    });
+    loop.loop();
+    driver.join();
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <mymuduo/Logger.h>
+#include <mymuduo/AsyncLogging.h>
+#include <mymuduo/Timestamp.h>
+
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+/**
+ * 测量一次LOG_INFO在调用线程上的耗时
+ * ./logbench > /dev/null
+*/
+
+static AsyncLogging* g_asyncLog = nullptr;
+
+static void nullOutput(const char* msg, size_t len)
+{
+}
+
+static void stdoutOutput(const char* msg, size_t len)
+{
+    ::fwrite(msg, 1, len, stdout);
+}
+
+static void asyncOutput(const char* msg, size_t len)
+{
+    g_asyncLog->append(msg, len);
+}
+
+static void bench(const char* name, int threads, int perThread)
+{
+    Timestamp start(Timestamp::now());
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([perThread]() {
+            for (int i = 0; i < perThread; ++i)
+            {
+                LOG_INFO("fd=%d events=%d index=%d %s", i, 3, 1, "hot path log line");
+            }
+        });
+    }
+    for (std::thread& w : workers)
+    {
+        w.join();
+    }
+    double seconds = timeDifference(Timestamp::now(), start);
+    fprintf(stderr, "%-24s threads=%d  %8.1f ns/call  %10.0f calls/s\n",
+            name, threads, seconds * 1e9 / perThread, threads * perThread / seconds);
+}
+
+int main(int argc, char* argv[])
+{
+    const int kCount = 1000 * 1000;
+
+    Logger::setOutput(nullOutput);
+    Logger::setLogLevel(ERROR);
+    bench("disabled level", 1, kCount * 100);
+    Logger::setLogLevel(INFO);
+    bench("format only", 1, kCount);
+
+    Logger::setOutput(stdoutOutput);
+    bench("sync stdout", 1, kCount);
+
+    AsyncLogging log("/tmp/logbench", 500 * 1000 * 1000);
+    log.start();
+    g_asyncLog = &log;
+    Logger::setOutput(asyncOutput);
+    bench("async file", 1, kCount);
+    bench("async file", 4, kCount / 4);
+    log.stop();
+    fprintf(stderr, "async dropped %ld messages\n", static_cast<long>(log.droppedMessages()));
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include <mymuduo/MpscQueue.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * MpscQueue的正确性检查，重点是生产者停在exchange head_和链接next之间时消费者的行为
+ * 用MpscQueueTester把push拆成两步，按固定的顺序交错执行，结果是确定的
+ * ./mpsctest
+*/
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            printf("    check failed: %s (line %d)\n", #cond, __LINE__); \
+            ok = false; \
+        } \
+    } while(0)
+
+typedef MpscQueue<int> Queue;
+
+struct MpscQueueTester
+{
+    typedef Queue::Node Node;
+
+    // 生产者的前半步：exchange之后返回prev，还没有链接prev->next
+    static Node* beginPush(Queue* q, int value, Node** node)
+    {
+        *node = new Node(value);
+        return q->head_.exchange(*node, std::memory_order_seq_cst);
+    }
+
+    // 生产者的后半步
+    static void finishPush(Node* prev, Node* node)
+    {
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    // popNode取唯一的元素A时，在判断A是最后一个和pushStub之间有生产者完成了exchange，
+    // 等生产者链接之后取出A。按popNode中的步骤逐步执行，返回A的值
+    static int popLastRacingWithPush(Queue* q, int value)
+    {
+        Node* a = q->stub_.next.load(std::memory_order_acquire);
+        q->tail_ = a; // 跳过stub
+        bool last = (a == q->head_.load(std::memory_order_seq_cst));
+
+        Node* b;
+        Node* prev = beginPush(q, value, &b); // 生产者停在这里
+
+        if (last)
+        {
+            q->pushStub();
+        }
+        finishPush(prev, b); // 生产者完成链接
+        q->tail_ = Queue::waitNext(a);
+
+        int result = a->value;
+        delete a;
+        return result;
+    }
+
+    static bool headIsStub(Queue* q)
+    {
+        return q->head_.load(std::memory_order_seq_cst) == &q->stub_;
+    }
+};
+
+// 取走最后一个元素时并发push的元素不能卡在队列里：队列是 B -> stub，head_指向stub
+static bool testPushDuringLastPop()
+{
+    bool ok = true;
+    Queue q;
+    q.push(1);
+    CHECK(MpscQueueTester::popLastRacingWithPush(&q, 2) == 1);
+    CHECK(MpscQueueTester::headIsStub(&q));
+    CHECK(!q.empty());
+
+    std::vector<int> got;
+    size_t n = q.consumeAll([&](int v) { got.push_back(v); });
+    CHECK(n == 1);
+    CHECK(got.size() == 1 && got[0] == 2);
+    CHECK(q.empty());
+
+    // 之后的push不受影响
+    q.push(3);
+    got.clear();
+    CHECK(q.consumeAll([&](int v) { got.push_back(v); }) == 1);
+    CHECK(got.size() == 1 && got[0] == 3);
+    CHECK(q.empty());
+    return ok;
+}
+
+// 同样的状态后面还有正常push的元素：stub之前和之后的元素都能取出，顺序不变
+static bool testPushDuringLastPopThenMore()
+{
+    bool ok = true;
+    Queue q;
+    q.push(1);
+    CHECK(MpscQueueTester::popLastRacingWithPush(&q, 2) == 1);
+    q.push(3);
+    q.push(4);
+
+    std::vector<int> got;
+    CHECK(q.consumeAll([&](int v) { got.push_back(v); }) == 3);
+    CHECK(got == std::vector<int>({ 2, 3, 4 }));
+    CHECK(q.empty());
+    return ok;
+}
+
+// 生产者停在exchange之后，消费者要等它链接完成，不能漏掉也不能提前返回
+static bool testConsumeWaitsForLink()
+{
+    bool ok = true;
+    Queue q;
+    q.push(1);
+    MpscQueueTester::Node* b;
+    MpscQueueTester::Node* prev = MpscQueueTester::beginPush(&q, 2, &b);
+
+    std::vector<int> got;
+    std::atomic_bool consumed(false);
+    std::thread consumer([&]() {
+        q.consumeAll([&](int v) { got.push_back(v); });
+        consumed = true;
+    });
+    usleep(20 * 1000);
+    CHECK(!consumed); // 还在等2链接
+    MpscQueueTester::finishPush(prev, b);
+    consumer.join();
+
+    CHECK(got == std::vector<int>({ 1, 2 }));
+    CHECK(q.empty());
+    return ok;
+}
+
+// f执行期间push的元素留到下一次consumeAll
+static bool testConsumeSnapshot()
+{
+    bool ok = true;
+    Queue q;
+    q.push(1);
+    q.push(2);
+    std::vector<int> got;
+    size_t n = q.consumeAll([&](int v) {
+        got.push_back(v);
+        q.push(v + 10);
+    });
+    CHECK(n == 2);
+    CHECK(got == std::vector<int>({ 1, 2 }));
+
+    got.clear();
+    CHECK(q.consumeAll([&](int v) { got.push_back(v); }) == 2);
+    CHECK(got == std::vector<int>({ 11, 12 }));
+    CHECK(q.empty());
+    CHECK(q.consumeAll([](int) {}) == 0);
+    return ok;
+}
+
+// 多个生产者并发push，每个元素恰好取出一次，同一个生产者的元素保持顺序
+static bool testManyProducers()
+{
+    bool ok = true;
+    const int kProducers = 4;
+    const int kPerProducer = 200000;
+    Queue q;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p)
+    {
+        producers.emplace_back([&q, p]() {
+            for (int i = 0; i < kPerProducer; ++i)
+            {
+                q.push(p * kPerProducer + i);
+            }
+        });
+    }
+
+    std::vector<int> next(kProducers, 0);
+    long total = 0;
+    bool ordered = true;
+    while (total < static_cast<long>(kProducers) * kPerProducer)
+    {
+        total += q.consumeAll([&](int v) {
+            int p = v / kPerProducer;
+            if (v % kPerProducer != next[p]++)
+            {
+                ordered = false;
+            }
+        });
+    }
+    for (std::thread& t : producers)
+    {
+        t.join();
+    }
+    CHECK(ordered);
+    CHECK(total == static_cast<long>(kProducers) * kPerProducer);
+    CHECK(q.empty());
+    return ok;
+}
+
+struct TestCase
+{
+    const char* name;
+    bool (*func)();
+};
+
+int main()
+{
+    const TestCase cases[] = {
+        { "push during last pop", testPushDuringLastPop },
+        { "push during last pop, then more", testPushDuringLastPopThenMore },
+        { "consume waits for link", testConsumeWaitsForLink },
+        { "consume snapshot", testConsumeSnapshot },
+        { "many producers", testManyProducers },
+    };
+
+    for (const TestCase& c : cases)
+    {
+        bool ok = c.func();
+        printf("[%s] %s\n", ok ? "PASS" : "FAIL", c.name);
+        if (!ok)
+        {
+            ++g_failures;
+        }
+    }
+
+    printf("%d failure(s)\n", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
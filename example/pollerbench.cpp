@@ -0,0 +1,144 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/Channel.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <memory>
+#include <vector>
+
+/**
+ * 不同Poller实现在不同fd个数下的开销
+ * 注册nfds个socketpair，每一轮向其中active个写一个字节，回调读走之后开始下一轮，
+ * 统计每轮的耗时（一次poll加上事件分发），即从写入到全部回调执行完的延迟
+ * ./pollerbench [active] [seconds]
+*/
+
+class Bench
+{
+public:
+    Bench(Poller::Backend backend, int nfds, int active)
+        : loop_(backend)
+        , active_(active)
+        , pending_(0)
+        , next_(0)
+        , rounds_(0)
+    {
+        for (int i = 0; i < nfds; ++i)
+        {
+            int fds[2];
+            if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0)
+            {
+                perror("socketpair");
+                exit(1);
+            }
+            writers_.push_back(fds[0]);
+            Channel* channel = new Channel(&loop_, fds[1]);
+            channel->setReadEventCallback([this, channel](Timestamp) { onRead(channel); });
+            channel->enableReading();
+            channels_.emplace_back(channel);
+        }
+    }
+
+    ~Bench()
+    {
+        for (size_t i = 0; i < channels_.size(); ++i)
+        {
+            channels_[i]->disableAll();
+            channels_[i]->remove();
+            ::close(channels_[i]->fd());
+            ::close(writers_[i]);
+        }
+    }
+
+    // 返回每轮的平均耗时（纳秒）
+    double run(double seconds)
+    {
+        loop_.runAfter(seconds, [this]() { stopped_ = true; });
+        stopped_ = false;
+        Timestamp start = Timestamp::now();
+        startRound();
+        loop_.loop();
+        double elapsed = timeDifference(Timestamp::now(), start);
+        return elapsed * 1e9 / rounds_;
+    }
+
+private:
+    void startRound()
+    {
+        if (stopped_)
+        {
+            loop_.quit();
+            return;
+        }
+        pending_ = active_;
+        // 每轮换一批fd，避免总是同样的几个
+        for (int i = 0; i < active_; ++i)
+        {
+            char c = 'x';
+            ::write(writers_[next_], &c, 1);
+            next_ = (next_ + 1) % writers_.size();
+        }
+    }
+
+    void onRead(Channel* channel)
+    {
+        char c;
+        ::read(channel->fd(), &c, 1);
+        if (--pending_ == 0)
+        {
+            ++rounds_;
+            startRound();
+        }
+    }
+
+    EventLoop loop_;
+    int active_;
+    int pending_;
+    size_t next_;
+    long rounds_;
+    bool stopped_;
+    std::vector<int> writers_;
+    std::vector<std::unique_ptr<Channel>> channels_;
+};
+
+int main(int argc, char* argv[])
+{
+    int active = argc > 1 ? atoi(argv[1]) : 1;
+    double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+    Logger::setLogLevel(ERROR);
+
+    const struct { const char* name; Poller::Backend backend; } backends[] = {
+        { "epoll", Poller::kEPoll },
+        { "poll", Poller::kPoll },
+        { "io_uring", Poller::kIoUring },
+    };
+    const int fdCounts[] = { 1, 4, 16, 64, 256, 1024 };
+
+    printf("%d active fd(s) per round, ns/round\n", active);
+    printf("%8s", "nfds");
+    for (const auto& b : backends)
+    {
+        printf("%12s", b.name);
+    }
+    printf("\n");
+    for (int nfds : fdCounts)
+    {
+        if (nfds < active)
+        {
+            continue;
+        }
+        printf("%8d", nfds);
+        for (const auto& b : backends)
+        {
+            Bench bench(b.backend, nfds, active);
+            printf("%12.0f", bench.run(seconds));
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    return 0;
+}
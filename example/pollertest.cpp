@@ -0,0 +1,342 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/Channel.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <memory>
+#include <vector>
+
+/**
+ * 所有Poller实现的一致性检查：注册、修改、删除、hasChannel以及事件的通知
+ * 每个用例分别在epoll、poll、io_uring上运行，有失败时返回非0
+ * ./pollertest
+*/
+
+static int g_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) \
+        { \
+            printf("    check failed: %s (line %d)\n", #cond, __LINE__); \
+            ok = false; \
+        } \
+    } while(0)
+
+// 一对socket，[0]用来写，[1]交给Channel
+struct SocketPair
+{
+    SocketPair()
+    {
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0)
+        {
+            perror("socketpair");
+            fds[0] = fds[1] = -1;
+        }
+    }
+    ~SocketPair()
+    {
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+    void send() { char c = 'x'; ::write(fds[0], &c, 1); }
+    void drain()
+    {
+        char buf[64];
+        while (::read(fds[1], buf, sizeof buf) > 0)
+        {
+        }
+    }
+
+    int fds[2];
+};
+
+// 运行loop直到某个回调调用quit，或者超过seconds秒
+static void runFor(EventLoop* loop, double seconds)
+{
+    TimerId timer = loop->runAfter(seconds, [loop]() { loop->quit(); });
+    loop->loop();
+    loop->cancel(timer);
+}
+
+// 注册读事件之后有数据可读时通知，hasChannel正确
+static bool testAddAndRead(EventLoop* loop)
+{
+    bool ok = true;
+    SocketPair sp;
+    Channel channel(loop, sp.fds[1]);
+    int reads = 0;
+    channel.setReadEventCallback([&](Timestamp) {
+        ++reads;
+        sp.drain();
+        loop->quit();
+    });
+    CHECK(!loop->hasChannel(&channel));
+    channel.enableReading();
+    CHECK(loop->hasChannel(&channel));
+
+    runFor(loop, 0.05);
+    CHECK(reads == 0);
+
+    sp.send();
+    runFor(loop, 1.0);
+    CHECK(reads == 1);
+
+    channel.disableAll();
+    channel.remove();
+    CHECK(!loop->hasChannel(&channel));
+    return ok;
+}
+
+// 修改感兴趣的事件：只关心写事件时不通知读事件
+static bool testModify(EventLoop* loop)
+{
+    bool ok = true;
+    SocketPair sp;
+    Channel channel(loop, sp.fds[1]);
+    int reads = 0;
+    int writes = 0;
+    channel.setReadEventCallback([&](Timestamp) { ++reads; sp.drain(); loop->quit(); });
+    channel.setWriteCallback([&]() { ++writes; loop->quit(); });
+
+    channel.enableReading();
+    channel.disableReading();
+    channel.enableWriting();
+    sp.send();
+    runFor(loop, 1.0);
+    CHECK(writes >= 1);
+    CHECK(reads == 0);
+
+    channel.disableWriting();
+    channel.enableReading();
+    writes = 0;
+    runFor(loop, 1.0);
+    CHECK(reads == 1);
+    CHECK(writes == 0);
+
+    channel.disableAll();
+    channel.remove();
+    return ok;
+}
+
+// disableAll之后不再通知，remove之后可以重新注册
+static bool testDisableAndRemove(EventLoop* loop)
+{
+    bool ok = true;
+    SocketPair sp;
+    std::unique_ptr<Channel> channel(new Channel(loop, sp.fds[1]));
+    int reads = 0;
+    channel->setReadEventCallback([&](Timestamp) { ++reads; sp.drain(); loop->quit(); });
+    channel->enableReading();
+    channel->disableAll();
+    CHECK(loop->hasChannel(channel.get()));
+    sp.send();
+    runFor(loop, 0.05);
+    CHECK(reads == 0);
+
+    channel->remove();
+    CHECK(!loop->hasChannel(channel.get()));
+
+    // 同一个fd换一个新的Channel重新注册
+    channel.reset(new Channel(loop, sp.fds[1]));
+    channel->setReadEventCallback([&](Timestamp) { ++reads; sp.drain(); loop->quit(); });
+    channel->enableReading();
+    runFor(loop, 1.0);
+    CHECK(reads == 1);
+
+    channel->disableAll();
+    channel->remove();
+    return ok;
+}
+
+// 水平触发：没有读走的数据下一轮继续通知
+static bool testLevelTriggered(EventLoop* loop)
+{
+    bool ok = true;
+    SocketPair sp;
+    Channel channel(loop, sp.fds[1]);
+    int reads = 0;
+    channel.setReadEventCallback([&](Timestamp) {
+        if (++reads == 3)
+        {
+            sp.drain();
+            loop->quit();
+        }
+    });
+    channel.enableReading();
+    sp.send();
+    runFor(loop, 1.0);
+    CHECK(reads == 3);
+
+    channel.disableAll();
+    channel.remove();
+    return ok;
+}
+
+// 很多Channel中只通知有数据的那些，中间的Channel删除之后其余的仍然正常
+static bool testManyChannels(EventLoop* loop)
+{
+    bool ok = true;
+    const int kCount = 64;
+    std::vector<std::unique_ptr<SocketPair>> pairs;
+    std::vector<std::unique_ptr<Channel>> channels;
+    std::vector<int> reads(kCount, 0);
+    int pending = 0;
+    for (int i = 0; i < kCount; ++i)
+    {
+        pairs.emplace_back(new SocketPair);
+        channels.emplace_back(new Channel(loop, pairs[i]->fds[1]));
+        channels[i]->setReadEventCallback([&, i](Timestamp) {
+            ++reads[i];
+            pairs[i]->drain();
+            if (--pending == 0)
+            {
+                loop->quit();
+            }
+        });
+        channels[i]->enableReading();
+    }
+
+    // 删除一半，剩下的被交换到新的位置
+    for (int i = 0; i < kCount; i += 2)
+    {
+        channels[i]->disableAll();
+        channels[i]->remove();
+        CHECK(!loop->hasChannel(channels[i].get()));
+    }
+    for (int i = 0; i < kCount; ++i)
+    {
+        pairs[i]->send();
+        if (i % 2 == 1)
+        {
+            ++pending;
+        }
+    }
+    runFor(loop, 1.0);
+    for (int i = 0; i < kCount; ++i)
+    {
+        CHECK(reads[i] == (i % 2 == 1 ? 1 : 0));
+    }
+
+    for (int i = 1; i < kCount; i += 2)
+    {
+        channels[i]->disableAll();
+        channels[i]->remove();
+    }
+    return ok;
+}
+
+// 对端关闭时通知，读到0
+static bool testPeerClose(EventLoop* loop)
+{
+    bool ok = true;
+    SocketPair sp;
+    Channel channel(loop, sp.fds[1]);
+    bool closed = false;
+    auto onClose = [&]() {
+        char c;
+        if (::read(sp.fds[1], &c, 1) == 0)
+        {
+            closed = true;
+            channel.disableAll();
+            loop->quit();
+        }
+    };
+    channel.setReadEventCallback([&](Timestamp) { onClose(); });
+    channel.setCloseCallback(onClose);
+    channel.enableReading();
+    ::shutdown(sp.fds[0], SHUT_WR);
+    runFor(loop, 1.0);
+    CHECK(closed);
+
+    channel.remove();
+    return ok;
+}
+
+// 边缘触发：不在写的时候不通知EPOLLOUT，enableWriting不需要重新注册也能收到写事件
+static bool testEdgeTriggered(EventLoop* loop)
+{
+    bool ok = true;
+    SocketPair sp;
+    Channel channel(loop, sp.fds[1]);
+    int reads = 0;
+    int writes = 0;
+    channel.setEdgeTriggered(true);
+    channel.setReadEventCallback([&](Timestamp) { ++reads; sp.drain(); loop->quit(); });
+    channel.setWriteCallback([&]() {
+        ++writes;
+        channel.disableWriting();
+        loop->quit();
+    });
+    channel.enableReading();
+    runFor(loop, 0.05);
+    CHECK(writes == 0);
+
+    sp.send();
+    runFor(loop, 1.0);
+    CHECK(reads == 1);
+
+    // 把发送缓冲区写满，再让对端读走，可写时收到通知
+    char buf[4096] = {0};
+    while (::write(sp.fds[1], buf, sizeof buf) > 0)
+    {
+    }
+    channel.enableWriting();
+    runFor(loop, 0.05);
+    CHECK(writes == 0);
+    while (::read(sp.fds[0], buf, sizeof buf) > 0)
+    {
+    }
+    runFor(loop, 1.0);
+    CHECK(writes == 1);
+
+    channel.disableAll();
+    channel.remove();
+    return ok;
+}
+
+struct TestCase
+{
+    const char* name;
+    bool (*func)(EventLoop*);
+};
+
+int main()
+{
+    Logger::setLogLevel(ERROR);
+
+    const TestCase cases[] = {
+        { "add/read", testAddAndRead },
+        { "modify", testModify },
+        { "disable/remove", testDisableAndRemove },
+        { "level-triggered", testLevelTriggered },
+        { "many channels", testManyChannels },
+        { "peer close", testPeerClose },
+        { "edge-triggered", testEdgeTriggered },
+    };
+    const struct { const char* name; Poller::Backend backend; } backends[] = {
+        { "epoll", Poller::kEPoll },
+        { "poll", Poller::kPoll },
+        { "io_uring", Poller::kIoUring },
+    };
+
+    for (const auto& b : backends)
+    {
+        EventLoop loop(b.backend);
+        for (const TestCase& c : cases)
+        {
+            bool ok = c.func(&loop);
+            printf("[%s] %-9s %s\n", ok ? "PASS" : "FAIL", b.name, c.name);
+            if (!ok)
+            {
+                ++g_failures;
+            }
+        }
+    }
+
+    printf("%d failure(s)\n", g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
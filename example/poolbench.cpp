@@ -0,0 +1,157 @@
+#include <mymuduo/UpstreamPool.h>
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/TcpConnection.h>
+#include <mymuduo/EventLoopThreadPool.h>
+#include <mymuduo/Logger.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * 网关向后端转发请求时连接池的效果
+ * 后端是单线程的echo服务器；网关有kLoops个loop，每个loop上kConcurrency个请求并发，
+ * 每个请求checkout一个连接，发送kMessageSize字节，收到完整的回复后release
+ * pooled：每个loop保留空闲连接，请求复用已经建立好的连接
+ * no reuse：release时标记不可复用，每个请求都新建连接，相当于不用连接池
+ * queued：每个loop最多2个连接，多出来的请求在等待队列中排队
+ * ./poolbench [seconds]
+*/
+
+static const int kLoops = 2;
+static const int kConcurrency = 8;
+static const size_t kMessageSize = 64;
+
+// 在一个网关loop上不停地发请求
+class Driver
+{
+public:
+    Driver(EventLoop* loop, UpstreamPool* pool, const InetAddress& addr, bool reuse, const std::atomic_bool* stop)
+        : loop_(loop)
+        , pool_(pool)
+        , addr_(addr)
+        , reuse_(reuse)
+        , stop_(stop)
+        , message_(kMessageSize, 'x')
+        , requests_(0)
+        , failures_(0)
+    {
+    }
+
+    void start() { loop_->runInLoop([this]() { next(); }); }
+
+    long requests() const { return requests_; }
+    long failures() const { return failures_; }
+
+private:
+    void next()
+    {
+        if (*stop_)
+        {
+            return;
+        }
+        pool_->checkout(loop_, addr_, [this](const TcpConnectionPtr& conn) { onCheckout(conn); });
+    }
+
+    void onCheckout(const TcpConnectionPtr& conn)
+    {
+        if (!conn)
+        {
+            ++failures_;
+            next();
+            return;
+        }
+        conn->setMessageCallback([this](const TcpConnectionPtr& c, Buffer* buf, Timestamp) {
+            if (buf->readableBytes() >= kMessageSize)
+            {
+                buf->retrieve(kMessageSize);
+                ++requests_;
+                pool_->release(c, reuse_);
+                next();
+            }
+        });
+        conn->send(message_);
+    }
+
+    EventLoop* loop_;
+    UpstreamPool* pool_;
+    InetAddress addr_;
+    bool reuse_;
+    const std::atomic_bool* stop_;
+    std::string message_;
+    long requests_; // 只在loop线程中修改，结束之后读取
+    long failures_;
+};
+
+static void run(const char* name, uint16_t port, bool reuse, size_t maxConnections, double seconds)
+{
+    EventLoop loop;
+    InetAddress addr(port);
+    TcpServer backend(&loop, addr, "Backend");
+    backend.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, Timestamp) {
+        conn->send(buf->retrieveAllAsString());
+    });
+    backend.start();
+
+    EventLoopThreadPool gateway(&loop, "Gateway");
+    gateway.setThreadNum(kLoops);
+    gateway.start();
+
+    std::atomic_bool stop(false);
+    std::unique_ptr<UpstreamPool> pool(new UpstreamPool(gateway.getAllLoops(), "Upstream"));
+    pool->setMaxIdle(kConcurrency);
+    pool->setMaxConnections(maxConnections);
+    std::vector<std::unique_ptr<Driver>> drivers;
+    for (EventLoop* ioLoop : gateway.getAllLoops())
+    {
+        for (int i = 0; i < kConcurrency; ++i)
+        {
+            drivers.emplace_back(new Driver(ioLoop, pool.get(), addr, reuse, &stop));
+        }
+    }
+
+    loop.runAfter(0.1, [&]() {
+        for (auto& d : drivers)
+        {
+            d->start();
+        }
+    });
+    loop.runAfter(0.1 + seconds, [&]() { stop = true; });
+    loop.runAfter(0.3 + seconds, [&]() { loop.quit(); });
+    loop.loop();
+
+    UpstreamPool::Stats stats = pool->stats();
+    pool.reset(); // 在网关loop中关闭所有连接，之后drivers不再被回调
+    long requests = 0;
+    long failures = 0;
+    for (auto& d : drivers)
+    {
+        requests += d->requests();
+        failures += d->failures();
+    }
+    printf("%-9s %9.0f %7.1f%% %8lu %8lu %9.1f %9.1f %9.1f %8ld\n",
+        name, requests / seconds, stats.hitRate() * 100,
+        (unsigned long)stats.connects, (unsigned long)stats.evictions,
+        stats.checkoutLatency.mean() / 1e3,
+        stats.checkoutLatency.percentile(0.50) / 1e3,
+        stats.checkoutLatency.percentile(0.99) / 1e3,
+        failures);
+}
+
+int main(int argc, char* argv[])
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    Logger::setLogLevel(ERROR);
+
+    printf("%d gateway loops x %d concurrent requests, %.1f s per run\n", kLoops, kConcurrency, seconds);
+    printf("checkout latency in us, percentiles are power-of-two bucket bounds\n");
+    printf("%-9s %9s %8s %8s %8s %9s %9s %9s %8s\n",
+        "mode", "req/s", "hit", "connects", "evicted", "mean", "p50", "p99", "timeouts");
+    run("pooled", 9022, true, 64, seconds);
+    run("no reuse", 9023, false, 64, seconds);
+    run("queued", 9024, true, 2, seconds);
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/EventLoopThread.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * 多个线程同时向同一个loop投递回调的吞吐
+ * legacy：原来的 mutex + vector + 每次投递都写eventfd（emplace_back拷贝std::function）
+ * mpsc  ：EventLoop::queueInLoop，无锁队列 + 合并唤醒
+ * ./postbench [producers] [postsPerProducer]
+*/
+
+class LegacyQueue
+{
+public:
+    using Functor = std::function<void()>;
+
+    LegacyQueue()
+        : wakeupfd_(::eventfd(0, EFD_CLOEXEC))
+        , quit_(false)
+        , thread_([this]() { loop(); })
+    {
+    }
+
+    ~LegacyQueue()
+    {
+        queueInLoop([this]() { quit_ = true; });
+        thread_.join();
+        ::close(wakeupfd_);
+    }
+
+    void queueInLoop(Functor cb)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            pendingFunctors_.emplace_back(cb);
+        }
+        uint64_t one = 1;
+        ::write(wakeupfd_, &one, sizeof one);
+    }
+
+private:
+    void loop()
+    {
+        while (!quit_)
+        {
+            uint64_t n;
+            ::read(wakeupfd_, &n, sizeof n);
+            std::vector<Functor> functors;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                functors.swap(pendingFunctors_);
+            }
+            for (const Functor& functor : functors)
+            {
+                functor();
+            }
+        }
+    }
+
+    int wakeupfd_;
+    bool quit_;
+    std::mutex mutex_;
+    std::vector<Functor> pendingFunctors_;
+    std::thread thread_;
+};
+
+struct Done
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool done = false;
+
+    void notify()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done = true;
+        cond.notify_one();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this]() { return done; });
+    }
+};
+
+template <typename Post>
+static void bench(const char* name, int producers, int perProducer, Post post)
+{
+    const long total = static_cast<long>(producers) * perProducer;
+    long counter = 0; // 只在loop线程中修改
+    Done done;
+    std::string payload(40, 'x'); // 和TcpConnection::send中bind的参数大小相近
+
+    Timestamp start(Timestamp::now());
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < perProducer; ++i)
+            {
+                post([&counter, &done, total, payload]() {
+                    if (++counter == total)
+                    {
+                        done.notify();
+                    }
+                });
+            }
+        });
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    done.wait();
+    double seconds = timeDifference(Timestamp::now(), start);
+    printf("%-8s producers=%-3d %10.0f posts/s  %7.1f ns/post\n",
+           name, producers, total / seconds, seconds * 1e9 / total);
+}
+
+int main(int argc, char* argv[])
+{
+    int producers = argc > 1 ? atoi(argv[1]) : 4;
+    int perProducer = argc > 2 ? atoi(argv[2]) : 1000 * 1000;
+    Logger::setLogLevel(ERROR);
+
+    {
+        LegacyQueue legacy;
+        bench("legacy", producers, perProducer,
+              [&legacy](std::function<void()> cb) { legacy.queueInLoop(std::move(cb)); });
+    }
+
+    {
+        EventLoopThread thread;
+        EventLoop* loop = thread.startLoop();
+        bench("mpsc", producers, perProducer,
+              [loop](std::function<void()> cb) { loop->queueInLoop(std::move(cb)); });
+    }
+    return 0;
+}
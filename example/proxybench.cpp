@@ -0,0 +1,277 @@
+#include <mymuduo/TcpServer.h>
+#include <mymuduo/TcpClient.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 持续过载时代理的内存占用
+ * 生产者尽快地向代理写数据，代理转发给后端，后端每kSinkIntervalMs毫秒只读kSinkReadBytes字节
+ * 不开背压时代理为后端连接缓冲的数据一直增长（超过kGiveUpBytes时提前结束）；
+ * 开背压时后端连接的输出超过高水位就暂停读入站连接，由TCP流量控制让生产者阻塞，缓冲的数据有上限
+ * 每kSampleInterval秒采样一次loop的待发送字节数
+ * ./proxybench [seconds]
+*/
+
+static const uint16_t kProxyPort = 9025;
+static const uint16_t kBackendPort = 9026;
+static const int kPairs = 2;
+static const size_t kHighWaterMark = 1024 * 1024;
+static const size_t kLowWaterMark = 256 * 1024;
+static const size_t kSinkReadBytes = 64 * 1024;
+static const int kSinkIntervalMs = 10;
+static const int64_t kGiveUpBytes = 512 * 1024 * 1024;
+static const double kSampleInterval = 0.02;
+
+class Proxy
+{
+public:
+    Proxy(EventLoop* loop, bool backpressure)
+        : loop_(loop)
+        , server_(loop, InetAddress(kProxyPort), "Proxy")
+        , backpressure_(backpressure)
+    {
+        server_.setConnectionCallback(std::bind(&Proxy::onConnection, this, std::placeholders::_1));
+        server_.setMessageCallback(std::bind(&Proxy::onMessage, this,
+            std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    }
+
+    // server_析构时还会回调onConnection，先清空pairs_
+    ~Proxy()
+    {
+        for (auto& item : pairs_)
+        {
+            item.second.outbound.reset();
+        }
+        pairs_.clear();
+    }
+
+    void start() { server_.start(); }
+
+private:
+    // 一个入站连接和它对应的后端连接
+    struct Pair
+    {
+        std::unique_ptr<TcpClient> client;
+        TcpConnectionPtr outbound;
+    };
+
+    void onConnection(const TcpConnectionPtr& inbound)
+    {
+        if (inbound->connected())
+        {
+            inbound->stopRead(); // 后端连上之前不读
+            Pair& pair = pairs_[inbound->name()];
+            pair.client.reset(new TcpClient(loop_, InetAddress(kBackendPort), "Backend"));
+            std::weak_ptr<TcpConnection> weakInbound(inbound);
+            pair.client->setConnectionCallback([this, weakInbound](const TcpConnectionPtr& outbound) {
+                TcpConnectionPtr inbound = weakInbound.lock();
+                if (!inbound)
+                {
+                    return;
+                }
+                if (outbound->connected())
+                {
+                    pairs_[inbound->name()].outbound = outbound;
+                    if (backpressure_)
+                    {
+                        outbound->setBackpressure(inbound, kHighWaterMark, kLowWaterMark);
+                    }
+                    inbound->startRead();
+                }
+                else
+                {
+                    inbound->shutdown();
+                }
+            });
+            pair.client->connect();
+        }
+        else
+        {
+            auto it = pairs_.find(inbound->name());
+            if (it != pairs_.end())
+            {
+                it->second.outbound.reset();
+                pairs_.erase(it);
+            }
+        }
+    }
+
+    void onMessage(const TcpConnectionPtr& inbound, Buffer* buf, Timestamp)
+    {
+        const TcpConnectionPtr& outbound = pairs_[inbound->name()].outbound;
+        if (outbound)
+        {
+            outbound->send(buf);
+        }
+    }
+
+    EventLoop* loop_;
+    TcpServer server_;
+    bool backpressure_;
+    std::map<std::string, Pair> pairs_; // 只在loop线程中访问
+};
+
+static int listenOn(uint16_t port)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0 || ::listen(fd, 16) < 0)
+    {
+        perror("listen");
+        exit(1);
+    }
+    return fd;
+}
+
+static int connectTo(uint16_t port)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) < 0)
+    {
+        perror("connect");
+        exit(1);
+    }
+    return fd;
+}
+
+// 读写超时，到时间之后阻塞的线程能够检查stop
+static void setTimeout(int fd)
+{
+    timeval tv = { 0, 100 * 1000 };
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+}
+
+static void run(const char* name, bool backpressure, double seconds)
+{
+    EventLoop loop;
+    Proxy proxy(&loop, backpressure);
+    proxy.start();
+
+    std::atomic_bool stop(false);
+    std::atomic<int64_t> produced(0);
+    std::atomic<int64_t> consumed(0);
+    int64_t peak = 0;
+    bool gaveUp = false;
+
+    int listenFd = listenOn(kBackendPort);
+    std::vector<std::thread> threads;
+    // 慢的后端
+    threads.emplace_back([&]() {
+        std::vector<std::thread> sinks;
+        for (int i = 0; i < kPairs; ++i)
+        {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            sinks.emplace_back([&, fd]() {
+                setTimeout(fd);
+                std::vector<char> buf(kSinkReadBytes);
+                while (!stop)
+                {
+                    ssize_t n = ::read(fd, buf.data(), buf.size());
+                    if (n == 0)
+                    {
+                        break;
+                    }
+                    if (n > 0)
+                    {
+                        consumed += n;
+                    }
+                    usleep(kSinkIntervalMs * 1000);
+                }
+                ::close(fd);
+            });
+        }
+        for (std::thread& t : sinks)
+        {
+            t.join();
+        }
+    });
+    // 尽快写的生产者
+    for (int i = 0; i < kPairs; ++i)
+    {
+        threads.emplace_back([&]() {
+            int fd = connectTo(kProxyPort);
+            setTimeout(fd);
+            std::string chunk(64 * 1024, 'p');
+            while (!stop)
+            {
+                ssize_t n = ::write(fd, chunk.data(), chunk.size());
+                if (n > 0)
+                {
+                    produced += n;
+                }
+                else if (errno != EAGAIN && errno != EINTR)
+                {
+                    break;
+                }
+            }
+            ::close(fd);
+        });
+    }
+
+    Timestamp start = Timestamp::now();
+    loop.runEvery(kSampleInterval, [&]() {
+        peak = std::max(peak, loop.pendingBytes());
+        if (peak > kGiveUpBytes)
+        {
+            gaveUp = true;
+        }
+        if (gaveUp || timeDifference(Timestamp::now(), start) >= seconds)
+        {
+            stop = true;
+            loop.quit();
+        }
+    });
+    loop.loop();
+    double elapsed = timeDifference(Timestamp::now(), start);
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    ::close(listenFd);
+
+    printf("%-13s %8.2f %12.1f %12.1f %14.1f%s\n", name, elapsed,
+        produced / elapsed / (1024 * 1024), consumed / elapsed / (1024 * 1024),
+        peak / (1024.0 * 1024), gaveUp ? " (gave up)" : "");
+}
+
+int main(int argc, char* argv[])
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 2.0;
+    Logger::setLogLevel(ERROR);
+
+    printf("%d connection pairs, sink reads %zu KB every %d ms, high/low water mark %zu/%zu KB\n",
+        kPairs, kSinkReadBytes / 1024, kSinkIntervalMs, kHighWaterMark / 1024, kLowWaterMark / 1024);
+    printf("%-13s %8s %12s %12s %14s\n", "mode", "seconds", "in (MB/s)", "out (MB/s)", "peak buf (MB)");
+    run("unbounded", false, seconds);
+    run("backpressure", true, seconds);
+    return 0;
+}
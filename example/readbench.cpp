@@ -0,0 +1,173 @@
+#include <mymuduo/Buffer.h>
+#include <mymuduo/BufferPool.h>
+#include <mymuduo/EventLoop.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/Timestamp.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <string>
+#include <vector>
+
+/**
+ * 小消息echo时Buffer::readFd的开销，socketpair一端发送，另一端readFd之后原样写回
+ * legacy：原来的实现，vector缓冲区 + 每次清零的64KB栈上溢出区
+ * buffer：Buffer::readFd，按预估大小预留空间 + 线程共享的溢出区
+ * pooled：使用BufferPool的Buffer，读完之后内存归还给内存池
+ * ./readbench [messageSize] [rounds]
+*/
+
+class LegacyBuffer
+{
+public:
+    static const size_t kCheapPrepend = 8;
+    static const size_t kInitialSize = 1024;
+
+    LegacyBuffer()
+        : buffer_(kCheapPrepend + kInitialSize)
+        , readerIndex_(kCheapPrepend)
+        , writerIndex_(kCheapPrepend)
+    {
+    }
+
+    size_t readableBytes() const { return writerIndex_ - readerIndex_; }
+    size_t writableBytes() const { return buffer_.size() - writerIndex_; }
+
+    void retrieveAll()
+    {
+        readerIndex_ = kCheapPrepend;
+        writerIndex_ = kCheapPrepend;
+    }
+
+    void append(const char* data, size_t len)
+    {
+        if (writableBytes() < len)
+        {
+            buffer_.resize(writerIndex_ + len);
+        }
+        std::copy(data, data + len, &buffer_[writerIndex_]);
+        writerIndex_ += len;
+    }
+
+    ssize_t readFd(int fd)
+    {
+        char extrabuf[65536] = {0};
+        iovec vec[2];
+        const size_t writable = writableBytes();
+        vec[0].iov_base = &buffer_[writerIndex_];
+        vec[0].iov_len = writable;
+        vec[1].iov_base = extrabuf;
+        vec[1].iov_len = sizeof(extrabuf);
+        const int iovcnt = (writable < sizeof(extrabuf)) ? 2 : 1;
+        const ssize_t n = ::readv(fd, vec, iovcnt);
+        if (n < 0)
+        {
+        }
+        else if (static_cast<size_t>(n) <= writable)
+        {
+            writerIndex_ += n;
+        }
+        else
+        {
+            writerIndex_ = buffer_.size();
+            append(extrabuf, n - writable);
+        }
+        return n;
+    }
+
+    ssize_t writeFd(int fd)
+    {
+        return ::write(fd, &buffer_[readerIndex_], readableBytes());
+    }
+
+private:
+    std::vector<char> buffer_;
+    size_t readerIndex_;
+    size_t writerIndex_;
+};
+
+static void readExactly(int fd, char* buf, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::read(fd, buf, len);
+        if (n <= 0)
+        {
+            perror("read");
+            exit(1);
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+// 返回每次echo的平均耗时（纳秒）
+template <typename Echo>
+static double run(const char* name, size_t msgSize, int rounds, Echo echo)
+{
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+    {
+        perror("socketpair");
+        exit(1);
+    }
+    std::string msg(msgSize, 'x');
+    std::string reply(msgSize, '\0');
+
+    Timestamp start = Timestamp::now();
+    for (int i = 0; i < rounds; ++i)
+    {
+        if (::write(fds[0], msg.data(), msg.size()) != static_cast<ssize_t>(msg.size()))
+        {
+            perror("write");
+            exit(1);
+        }
+        echo(fds[1]);
+        readExactly(fds[0], &reply[0], reply.size());
+    }
+    double seconds = timeDifference(Timestamp::now(), start);
+    double ns = seconds * 1e9 / rounds;
+    printf("%-8s %8.1f ns/echo %10.0f echo/s\n", name, ns, rounds / seconds);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+    return ns;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t msgSize = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 32;
+    int rounds = argc > 2 ? atoi(argv[2]) : 500000;
+    Logger::setLogLevel(ERROR);
+    printf("message size %zu bytes, %d rounds\n", msgSize, rounds);
+
+    LegacyBuffer legacy;
+    run("legacy", msgSize, rounds, [&](int fd) {
+        legacy.readFd(fd);
+        legacy.writeFd(fd);
+        legacy.retrieveAll();
+    });
+
+    Buffer buffer;
+    run("buffer", msgSize, rounds, [&](int fd) {
+        int savedErrno = 0;
+        buffer.readFd(fd, &savedErrno);
+        buffer.writeFd(fd, &savedErrno);
+        buffer.retrieveAll();
+    });
+
+    EventLoop loop; // BufferPool只能在loop线程中使用
+    Buffer pooled(loop.bufferPool());
+    run("pooled", msgSize, rounds, [&](int fd) {
+        int savedErrno = 0;
+        pooled.readFd(fd, &savedErrno);
+        pooled.writeFd(fd, &savedErrno);
+        pooled.retrieveAll();
+    });
+
+    return 0;
+}
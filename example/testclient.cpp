@@ -0,0 +1,61 @@
+#include <mymuduo/TcpClient.h>
+#include <mymuduo/Logger.h>
+#include <mymuduo/TcpConnection.h>
+
+#include <stdio.h>
+
+/**
+ * testserver的客户端：连上之后发送一行，打印回显；testserver回显之后会关闭连接，
+ * 开启了重连，每次断开都会重新连接，testserver没有启动时按退避间隔重试
+*/
+class EchoClient
+{
+public:
+    EchoClient(EventLoop* loop, const InetAddress& serverAddr)
+        : client_(loop, serverAddr, "EchoClient")
+        , count_(0)
+    {
+        client_.setConnectionCallback(
+            std::bind(&EchoClient::onConnection, this, std::placeholders::_1));
+        client_.setMessageCallback(
+            std::bind(&EchoClient::onMessage, this, std::placeholders::_1, std::placeholders::_2,
+                std::placeholders::_3));
+        client_.enableRetry();
+    }
+
+    void connect()
+    {
+        client_.connect();
+    }
+
+private:
+    void onConnection(const TcpConnectionPtr& conn)
+    {
+        if (conn->connected())
+        {
+            char buf[32];
+            snprintf(buf, sizeof buf, "hello %d\n", ++count_);
+            conn->send(buf);
+        }
+    }
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp time)
+    {
+        printf("%s", buf->retrieveAllAsString().c_str());
+    }
+
+    TcpClient client_;
+    int count_;
+};
+
+int main()
+{
+    EventLoop loop;
+    InetAddress serverAddr(8000);
+    EchoClient client(&loop, serverAddr);
+    client.connect();
+    loop.runAfter(5.0, [&loop]() { loop.quit(); });
+    loop.loop();
+
+    return 0;
+}